@@ -8,6 +8,19 @@
 #include <algorithm>
 #include <cctype>
 #include <chrono>
+#include <string_view>
+#include <charconv>
+#include <system_error>
+#include <memory>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -18,47 +31,387 @@ string toLower(const string &str)
     return lowerStr;
 }
 
+// mapped files
+
+// Read-only view of a whole file, so the loaders can tokenize it in place.
+class MappedFile
+{
+public:
+    const char *data = nullptr;
+    size_t size = 0;
+
+    MappedFile() {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile()
+    {
+        close();
+    }
+
+    bool open(const string &filename);
+    void close();
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+#ifdef _WIN32
+bool MappedFile::open(const string &filename)
+{
+    close();
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER bytes;
+    if (!GetFileSizeEx(file, &bytes))
+    {
+        close();
+        return false;
+    }
+    size = (size_t)bytes.QuadPart;
+    if (size == 0)
+    {
+        return true;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    data = mapping == nullptr ? nullptr : (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::open(const string &filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    size = (size_t)info.st_size;
+    if (size > 0)
+    {
+        void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+        data = (const char *)view;
+        madvise(view, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        munmap((void *)data, size);
+    }
+    data = nullptr;
+    size = 0;
+}
+#endif
+
+// Whitespace-separated tokens of a mapped file, as views into the mapping.
+class TokenReader
+{
+public:
+    TokenReader(const char *begin, const char *end) : p(begin), end(end) {}
+
+    bool next(string_view &token)
+    {
+        while (p < end && isspace((unsigned char)*p))
+        {
+            ++p;
+        }
+        const char *start = p;
+        while (p < end && !isspace((unsigned char)*p))
+        {
+            ++p;
+        }
+        token = string_view(start, p - start);
+        return p > start;
+    }
+
+    bool nextInt(int &value)
+    {
+        string_view token;
+        if (!next(token))
+        {
+            return false;
+        }
+        auto result = from_chars(token.data(), token.data() + token.size(), value);
+        return result.ec == errc() && result.ptr == token.data() + token.size();
+    }
+
+private:
+    const char *p;
+    const char *end;
+};
+
+// symbol table
+
+inline char foldCase(char c)
+{
+    return c >= 'A' && c <= 'Z' ? (char)(c + ('a' - 'A')) : c;
+}
+
+// Maps case-folded names to dense ids 0, 1, 2, ... Names are folded and
+// hashed once while a graph is loaded; the engines only work on the ids and
+// the names are looked up again only to print results. Folded names live in
+// one arena of large blocks, and the flat open-addressing table holds a view
+// of each name with its hash and id, so looking a name up never allocates
+// and interning allocates only when a block or the table fills up.
+class SymbolTable
+{
+public:
+    // Sizes the table for count names and the arena for bytes of name text.
+    void reserve(int count, size_t bytes)
+    {
+        size_t needed = 16;
+        while (needed < (size_t)count * 2)
+        {
+            needed *= 2;
+        }
+        if (needed > slots.size())
+        {
+            rehash(needed);
+        }
+        names.reserve(count);
+        if (bytes > 0 && arenaLeft < bytes)
+        {
+            newBlock(bytes);
+        }
+    }
+
+    int intern(string_view name)
+    {
+        if ((names.size() + 1) * 2 > slots.size())
+        {
+            rehash(max<size_t>(16, slots.size() * 2));
+        }
+        uint32_t hash = foldHash(name);
+        size_t slot = probe(name, hash);
+        if (slots[slot].id >= 0)
+        {
+            return slots[slot].id;
+        }
+
+        int id = (int)names.size();
+        names.push_back(store(name));
+        slots[slot] = {names.back(), hash, id};
+        return id;
+    }
+
+    // -1 for a name that was never interned
+    int find(string_view name) const
+    {
+        if (slots.empty())
+        {
+            return -1;
+        }
+        return slots[probe(name, foldHash(name))].id;
+    }
+
+    string_view name(int id) const
+    {
+        return names[id];
+    }
+
+    int size() const
+    {
+        return (int)names.size();
+    }
+
+private:
+    struct Slot
+    {
+        string_view name; // folded, in the arena
+        uint32_t hash;
+        int id; // -1 marks an empty slot
+    };
+    vector<Slot> slots;
+    vector<string_view> names;
+    vector<unique_ptr<char[]>> blocks;
+    char *arenaNext = nullptr;
+    size_t arenaLeft = 0;
+    size_t blockSize = 1 << 16; // doubles per block up to 16 MB
+
+    // FNV-1a over the folded bytes
+    static uint32_t foldHash(string_view name)
+    {
+        uint32_t hash = 2166136261u;
+        for (char c : name)
+        {
+            hash = (hash ^ (unsigned char)foldCase(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    static bool sameName(string_view folded, string_view name)
+    {
+        if (folded.size() != name.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            if (folded[i] != foldCase(name[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // slot holding name, or the empty slot where it would go
+    size_t probe(string_view name, uint32_t hash) const
+    {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot].id >= 0 && (slots[slot].hash != hash || !sameName(slots[slot].name, name)))
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void rehash(size_t capacity)
+    {
+        vector<Slot> old(capacity, Slot{string_view(), 0, -1});
+        old.swap(slots);
+        for (const Slot &entry : old)
+        {
+            if (entry.id >= 0)
+            {
+                size_t slot = entry.hash & (capacity - 1);
+                while (slots[slot].id >= 0)
+                {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                slots[slot] = entry;
+            }
+        }
+    }
+
+    void newBlock(size_t bytes)
+    {
+        size_t size = max(bytes, blockSize);
+        blockSize = min<size_t>(blockSize * 2, 1 << 24);
+        blocks.emplace_back(new char[size]);
+        arenaNext = blocks.back().get();
+        arenaLeft = size;
+    }
+
+    // copies the folded name into the arena; earlier views stay valid
+    string_view store(string_view name)
+    {
+        if (arenaLeft < name.size())
+        {
+            newBlock(name.size());
+        }
+        char *copy = arenaNext;
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            copy[i] = foldCase(name[i]);
+        }
+        arenaNext += name.size();
+        arenaLeft -= name.size();
+        return string_view(copy, name.size());
+    }
+};
+
 // dijkstra
 
 class DijkstraGraph
 {
 public:
-    void addEdge(const string &u, const string &v, int weight)
+    SymbolTable users;
+
+    // Room for the counts from a file header, so loading does not reallocate.
+    void reserve(int userCount, int connectionCount, size_t nameBytes)
     {
-        string uLower = toLower(u);
-        string vLower = toLower(v);
-        adjList[uLower].push_back({vLower, weight});
-        adjList[vLower].push_back({uLower, weight});
+        users.reserve(userCount, nameBytes);
+        connections.reserve(connectionCount);
     }
 
-    unordered_map<string, int> dijkstra(const string &src)
+    void addEdge(string_view u, string_view v, int weight)
     {
-        string srcLower = toLower(src);
+        int uId = users.intern(u);
+        int vId = users.intern(v);
+        connections.push_back({uId, vId, weight});
+        built = false;
+    }
 
-        unordered_map<string, int> dist;
-        for (auto &pair : adjList)
+    // Distances from src indexed by user id; empty if src is unknown.
+    vector<int> dijkstra(string_view src)
+    {
+        int srcId = users.find(src);
+        if (srcId < 0)
         {
-            dist[pair.first] = INT_MAX;
+            return {};
         }
-        dist[srcLower] = 0;
+        build();
+
+        vector<int> dist(users.size(), INT_MAX);
+        dist[srcId] = 0;
 
-        using pii = pair<int, string>;
+        using pii = pair<int, int>;
         priority_queue<pii, vector<pii>, greater<pii>> pq;
-        pq.push({0, srcLower});
+        pq.push({0, srcId});
 
         while (!pq.empty())
         {
             int currentDist = pq.top().first;
-            string u = pq.top().second;
+            int u = pq.top().second;
             pq.pop();
 
             if (currentDist > dist[u])
                 continue;
 
-            for (auto &neighbor : adjList[u])
+            for (int k = offsets[u]; k < offsets[u + 1]; ++k)
             {
-                string v = neighbor.first;
-                int weight = neighbor.second;
+                int v = arcs[k].first;
+                int weight = arcs[k].second;
 
                 if (dist[u] + weight < dist[v])
                 {
@@ -72,14 +425,75 @@ public:
     }
 
 private:
-    unordered_map<string, vector<pair<string, int>>> adjList;
+    struct Connection
+    {
+        int u, v, weight;
+    };
+    vector<Connection> connections;
+
+    // both directions of every connection grouped by user: the neighbours
+    // of u are arcs[offsets[u]] .. arcs[offsets[u + 1] - 1], as (id, distance)
+    vector<int> offsets;
+    vector<pair<int, int>> arcs;
+    bool built = false;
+
+    void build()
+    {
+        if (built)
+        {
+            return;
+        }
+        int V = users.size();
+        offsets.assign(V + 1, 0);
+        for (const Connection &c : connections)
+        {
+            ++offsets[c.u + 1];
+            ++offsets[c.v + 1];
+        }
+        for (int u = 0; u < V; ++u)
+        {
+            offsets[u + 1] += offsets[u];
+        }
+        arcs.resize(offsets[V]);
+        vector<int> next(offsets.begin(), offsets.end() - 1);
+        for (const Connection &c : connections)
+        {
+            arcs[next[c.u]++] = {c.v, c.weight};
+            arcs[next[c.v]++] = {c.u, c.weight};
+        }
+        built = true;
+    }
 };
 
+// Prints the distances from srcUser sorted by distance, names last.
+void printUserDistances(const DijkstraGraph &g, string_view srcUser, const vector<int> &distances)
+{
+    if (distances.empty())
+    {
+        cout << "Unknown user " << srcUser << endl;
+        return;
+    }
+
+    cout << "Shortest paths from " << srcUser << " to all destinations (sorted by distance):\n";
+    vector<int> order(distances.size());
+    for (int id = 0; id < (int)order.size(); ++id)
+    {
+        order[id] = id;
+    }
+    stable_sort(order.begin(), order.end(), [&](int a, int b)
+                { return distances[a] < distances[b]; });
+
+    for (int id : order)
+    {
+        cout << "To " << g.users.name(id) << ": " << distances[id] << '\n';
+    }
+}
+
 // bellman-ford
 
 struct bellEdge
 {
-    string source, destination;
+    int source, destination; // city ids
     int weight;
 };
 
@@ -87,55 +501,78 @@ class Bellmanford
 {
     int V;
     vector<bellEdge> edges;
-    unordered_map<string, int> cityIndices;
+    SymbolTable cities;
 
 public:
     Bellmanford(int vertices) : V(vertices) {}
 
-    void addEdge(string u, string v, int w)
+    // Room for the counts from a file header, so loading does not reallocate.
+    void reserve(int roadCount, size_t nameBytes)
     {
-        edges.push_back({u, v, w});
+        cities.reserve(V, nameBytes);
+        edges.reserve(roadCount);
     }
 
-    void printSolution(const vector<int> &dist, string src)
+    // a name listed twice is one city
+    void addCity(string_view name)
+    {
+        cities.intern(name);
+        V = cities.size();
+    }
+
+    // Returns false, adding nothing, if either city is not in the city list.
+    bool addEdge(string_view u, string_view v, int w)
     {
-        // Create a vector of pairs (city, distance)
-        vector<pair<string, int>> distances;
-        for (const auto &cityIndexPair : cityIndices)
+        int uId = cities.find(u);
+        int vId = cities.find(v);
+        if (uId < 0 || vId < 0)
         {
-            string dest = cityIndexPair.first;
-            int index = cityIndexPair.second;
-            distances.push_back({dest, dist[index]});
+            return false;
         }
+        edges.push_back({uId, vId, w});
+        return true;
+    }
 
-        // Sort distances in increasing order
-        sort(distances.begin(), distances.end(), [](const pair<string, int> &a, const pair<string, int> &b)
-             { return a.second < b.second; });
+    void printSolution(const vector<int> &dist, string src)
+    {
+        // city ids in increasing order of distance
+        vector<int> order(V);
+        for (int i = 0; i < V; ++i)
+        {
+            order[i] = i;
+        }
+        stable_sort(order.begin(), order.end(), [&](int a, int b)
+                    { return dist[a] < dist[b]; });
 
         cout << "Shortest distances from " << src << " to all other cities in increasing order:\n";
-        for (const auto &distance : distances)
+        for (int city : order)
         {
-            cout << "Distance to " << distance.first << ": " << distance.second << endl;
+            cout << "Distance to " << cities.name(city) << ": " << dist[city] << endl;
         }
     }
 
     void bellmanFord(string src)
     {
+        int srcId = cities.find(src);
+        if (srcId < 0)
+        {
+            cout << "Unknown city " << src << endl;
+            return;
+        }
         vector<int> dist(V, INT_MAX);
-        dist[cityIndices[toLower(src)]] = 0;
-        // Convert src to lowercase
+        dist[srcId] = 0;
         auto start = chrono::high_resolution_clock::now(); // Start the timer
 
         for (int i = 0; i < V - 1; ++i)
         {
             for (const auto &edge : edges)
             {
-                string u = edge.source;
-                string v = edge.destination;
+                int u = edge.source;
+                int v = edge.destination;
                 int weight = edge.weight;
-                if (dist[cityIndices[toLower(u)]] != INT_MAX && dist[cityIndices[toLower(u)]] + weight < dist[cityIndices[toLower(v)]])
+                if (dist[u] != INT_MAX && dist[u] + weight < dist[v])
                 {
-                    dist[cityIndices[toLower(v)]] = dist[cityIndices[toLower(u)]] + weight;
+                    dist[v] = dist[u] + weight;
                 }
             }
         }
@@ -146,11 +583,11 @@ public:
         cout << "Time taken: " << duration.count() << " microseconds" << endl;    // Output the time taken
     }
 
-    void setCityIndices(const vector<string> &cities)
+    void setCityIndices(const vector<string> &names)
     {
-        for (int i = 0; i < V; ++i)
+        for (const string &name : names)
         {
-            cityIndices[toLower(cities[i])] = i;
+            addCity(name);
         }
     }
 };
@@ -158,47 +595,51 @@ public:
 // dijkstra
 void loadFileFromDijkstra()
 {
-    DijkstraGraph g;
-    ifstream inputFile("socialList.txt");
-    if (!inputFile.is_open())
+    MappedFile file;
+    if (!file.open("socialList.txt"))
     {
         cerr << "Unable to open file.\n";
         return;
     }
 
+    auto start = chrono::high_resolution_clock::now();
+    TokenReader input(file.data, file.data + file.size);
     int numUsers, numConnections;
-    inputFile >> numUsers >> numConnections;
-    inputFile.ignore(); // Ignore remaining newline character
+    if (!input.nextInt(numUsers) || !input.nextInt(numConnections) || numUsers < 0 || numConnections < 0)
+    {
+        cerr << "Invalid number of users or connections.\n";
+        return;
+    }
 
+    // every name and connection takes at least two bytes of the file, so a
+    // damaged header cannot make reserve ask for more than that
+    size_t fileLimit = file.size / 2;
+    DijkstraGraph g;
+    g.reserve((int)min<size_t>(numUsers, fileLimit), (int)min<size_t>(numConnections, fileLimit), 0);
     for (int i = 0; i < numConnections; ++i)
     {
-        string source, destination;
+        string_view source, destination;
         int distance;
-        inputFile >> source >> destination >> distance;
+        if (!input.next(source) || !input.next(destination) || !input.nextInt(distance))
+        {
+            cerr << "Connection " << i + 1 << " is incomplete.\n";
+            return;
+        }
         g.addEdge(source, destination, distance);
     }
 
-    string srcUser;
-    inputFile.ignore(); // Ignore remaining newline character
-    getline(inputFile, srcUser);
-
-    inputFile.close();
-
-    unordered_map<string, int> distances = g.dijkstra(srcUser);
-
-    cout << "Shortest paths from " << srcUser << " to all destinations (sorted by distance):\n";
-    vector<pair<string, int>> sortedDistances;
-    for (const auto &pair : distances)
+    string_view srcUser;
+    if (!input.next(srcUser))
     {
-        sortedDistances.push_back(pair);
+        cerr << "Source user is missing.\n";
+        return;
     }
-    sort(sortedDistances.begin(), sortedDistances.end(), [](const auto &a, const auto &b)
-         { return a.second < b.second; });
+    auto end = chrono::high_resolution_clock::now();
+    cout << "Loaded " << g.users.size() << " users and " << numConnections << " connections in "
+         << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
 
-    for (const auto &pair : sortedDistances)
-    {
-        cout << "To " << pair.first << ": " << pair.second << '\n';
-    }
+    vector<int> distances = g.dijkstra(srcUser);
+    printUserDistances(g, srcUser, distances);
 }
 
 void loadManualyDijkstra()
@@ -231,21 +672,9 @@ void loadManualyDijkstra()
     cout << "Enter source username: ";
     getline(cin, srcUser);
 
-    unordered_map<string, int> distances = g.dijkstra(srcUser);
-
-    cout << "Shortest paths from " << srcUser << " to all destinations (sorted by distance):\n";
-    vector<pair<string, int>> sortedDistances;
-    for (const auto &pair : distances)
-    {
-        sortedDistances.push_back(pair);
-    }
-    sort(sortedDistances.begin(), sortedDistances.end(), [](const auto &a, const auto &b)
-         { return a.second < b.second; });
+    vector<int> distances = g.dijkstra(srcUser);
 
-    for (const auto &pair : sortedDistances)
-    {
-        cout << "To " << pair.first << ": " << pair.second << '\n';
-    }
+    printUserDistances(g, srcUser, distances);
 }
 // bellmen-ford
 void inputManuallyBellmenFord()
@@ -273,7 +702,10 @@ void inputManuallyBellmenFord()
         string startCity, endCity;
         int length;
         cin >> startCity >> endCity >> length;
-        g.addEdge(startCity, endCity, length);
+        if (!g.addEdge(startCity, endCity, length))
+        {
+            cout << "Unknown city in road " << startCity << " " << endCity << ", skipped." << endl;
+        }
     }
 
     string startCity;
@@ -285,41 +717,64 @@ void inputManuallyBellmenFord()
 
 void loadfromFileBellmenFord()
 {
-    ifstream inputFile("citysList.txt");
-    if (!inputFile)
+    MappedFile file;
+    if (!file.open("citysList.txt"))
     {
         cerr << "Error: Unable to open input file." << endl;
         return;
     }
 
+    TokenReader input(file.data, file.data + file.size);
     int numCities, numRoads;
-    inputFile >> numCities;
+    if (!input.nextInt(numCities) || numCities <= 0)
+    {
+        cerr << "Error: Invalid number of cities." << endl;
+        return;
+    }
 
-    vector<string> cities(numCities);
+    Bellmanford g((int)min<size_t>(numCities, file.size / 2));
+    g.reserve(0, 0);
     for (int i = 0; i < numCities; ++i)
     {
-        inputFile >> cities[i];
+        string_view city;
+        if (!input.next(city))
+        {
+            cerr << "Error: City " << i + 1 << " is missing." << endl;
+            return;
+        }
+        g.addCity(city);
     }
 
-    inputFile >> numRoads;
-
-    Bellmanford g(numCities);
-    g.setCityIndices(cities);
+    if (!input.nextInt(numRoads) || numRoads < 0)
+    {
+        cerr << "Error: Invalid number of roads." << endl;
+        return;
+    }
+    g.reserve((int)min<size_t>(numRoads, file.size / 2), 0);
 
     for (int i = 0; i < numRoads; ++i)
     {
-        string startCity, endCity;
+        string_view startCity, endCity;
         int length;
-        inputFile >> startCity >> endCity >> length;
-        g.addEdge(startCity, endCity, length);
+        if (!input.next(startCity) || !input.next(endCity) || !input.nextInt(length))
+        {
+            cerr << "Error: Road " << i + 1 << " is incomplete." << endl;
+            return;
+        }
+        if (!g.addEdge(startCity, endCity, length))
+        {
+            cout << "Unknown city in road " << startCity << " " << endCity << ", skipped." << endl;
+        }
     }
 
-    string startCity;
-    inputFile >> startCity;
-
-    g.bellmanFord(toLower(startCity));
+    string_view startCity;
+    if (!input.next(startCity))
+    {
+        cerr << "Error: Start city is missing." << endl;
+        return;
+    }
 
-    inputFile.close();
+    g.bellmanFord(toLower(string(startCity)));
 }
 
 // gps application
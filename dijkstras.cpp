@@ -20,27 +20,97 @@ class DijkstraGraph
 {
 public:
     int V;
-    vector<vector<Edge>> adjList;
+    vector<vector<Edge>> adjList; // mutable builder, released by freeze()
+
+    // frozen CSR form: the edges leaving u are [offsets[u], offsets[u + 1])
+    vector<int> offsets;
+    vector<int> edgeDest;
+    vector<int> edgeWeight;
+    bool frozen;
 
     DijkstraGraph(int V)
     {
         this->V = V;
         adjList.resize(V);
+        frozen = false;
     }
 
     void addEdge(int u, int v, int weight)
     {
+        if (frozen)
+        {
+            thaw();
+        }
         adjList[u].push_back({v, weight});
     }
 
+    void freeze();
+    void thaw();
     void dijkstra(int src);
 };
 
+// Packs the adjacency lists into the contiguous CSR arrays. Call once after
+// loading; dijkstra() freezes on its own if the graph is still mutable.
+void DijkstraGraph::freeze()
+{
+    if (frozen)
+    {
+        return;
+    }
+
+    offsets.assign(V + 1, 0);
+    for (int u = 0; u < V; ++u)
+    {
+        offsets[u + 1] = offsets[u] + (int)adjList[u].size();
+    }
+
+    edgeDest.resize(offsets[V]);
+    edgeWeight.resize(offsets[V]);
+    for (int u = 0; u < V; ++u)
+    {
+        int k = offsets[u];
+        for (const Edge &edge : adjList[u])
+        {
+            edgeDest[k] = edge.dest;
+            edgeWeight[k] = edge.weight;
+            ++k;
+        }
+    }
+
+    vector<vector<Edge>>().swap(adjList);
+    frozen = true;
+}
+
+// Rebuilds the adjacency lists from the CSR arrays so addEdge can be used again.
+void DijkstraGraph::thaw()
+{
+    adjList.assign(V, vector<Edge>());
+    for (int u = 0; u < V; ++u)
+    {
+        adjList[u].reserve(offsets[u + 1] - offsets[u]);
+        for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+        {
+            adjList[u].push_back({edgeDest[k], edgeWeight[k]});
+        }
+    }
+
+    vector<int>().swap(offsets);
+    vector<int>().swap(edgeDest);
+    vector<int>().swap(edgeWeight);
+    frozen = false;
+}
+
 void DijkstraGraph::dijkstra(int src)
 {
+    freeze();
+
     vector<int> dist(V, INT_MAX);
     dist[src] = 0;
 
+    const int *rowStart = offsets.data();
+    const int *dest = edgeDest.data();
+    const int *weights = edgeWeight.data();
+
     auto start = high_resolution_clock::now(); // Start measuring time
 
     priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
@@ -51,10 +121,10 @@ void DijkstraGraph::dijkstra(int src)
         int u = pq.top().second;
         pq.pop();
 
-        for (const Edge &edge : adjList[u])
+        for (int k = rowStart[u]; k < rowStart[u + 1]; ++k)
         {
-            int v = edge.dest;
-            int weight = edge.weight;
+            int v = dest[k];
+            int weight = weights[k];
 
             if (dist[u] + weight < dist[v])
             {
@@ -101,6 +171,7 @@ void inputGraphManually()
         cin >> u >> v >> w;
         g.addEdge(u, v, w);
     }
+    g.freeze();
 
     int src;
     cout << "Enter the source user: ";
@@ -132,6 +203,7 @@ void loadGraphFromFile()
     }
 
     file.close();
+    g.freeze();
 
     int src;
     cout << "Enter the source user: ";
@@ -1,401 +1,8178 @@
+// Build: g++ -std=c++17 -O2 -pthread mainProject.cpp -o mainProject
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <deque>
+#include <unordered_map>
+#include <list>
 #include <climits>
+#include <limits>
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <filesystem>
+#include <charconv>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <random>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 using namespace std::chrono;
 
-// dijkstra's
-struct DijEdge
-{
-    int dest, weight;
-};
-
-class DijkstraGraph
+// thread pool
+//
+// Fork-join pool: runOnAll hands the same task to every worker (the calling
+// thread is worker 0) and returns once all of them have finished. Phase based
+// algorithms call it once per phase, so the threads are created only once.
+class ThreadPool
 {
 public:
-    int V;
-    vector<vector<DijEdge>> adjList;
-
-    DijkstraGraph(int V)
+    ThreadPool(int threads)
     {
-        this->V = V;
-        adjList.resize(V);
+        count = max(1, threads);
+        for (int i = 1; i < count; ++i)
+        {
+            workers.emplace_back([this, i]
+                                 { workerLoop(i); });
+        }
     }
 
-    void addEdge(int u, int v, int weight)
+    ~ThreadPool()
     {
-        adjList[u].push_back({v, weight});
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+            ++generation;
+        }
+        wake.notify_all();
+        for (thread &t : workers)
+        {
+            t.join();
+        }
     }
 
-    void dijkstra(int src);
-};
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
 
-void DijkstraGraph::dijkstra(int src)
-{
-    vector<int> dist(V, INT_MAX);
-    dist[src] = 0;
+    int size() const
+    {
+        return count;
+    }
 
-    auto start = high_resolution_clock::now(); // Start measuring time
+    void runOnAll(const function<void(int)> &task)
+    {
+        if (count == 1)
+        {
+            task(0);
+            return;
+        }
+        {
+            lock_guard<mutex> lock(m);
+            current = &task;
+            pending = count - 1;
+            ++generation;
+        }
+        wake.notify_all();
+        task(0);
 
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
-    pq.push({0, src});
+        unique_lock<mutex> lock(m);
+        done.wait(lock, [this]
+                  { return pending == 0; });
+        current = nullptr;
+    }
 
-    while (!pq.empty())
+    // Splits [0, n) into chunks of grain items handed out on demand, so uneven
+    // chunks (high degree vertices) balance out. body(begin, end, worker).
+    void parallelFor(int n, int grain, const function<void(int, int, int)> &body)
     {
-        int u = pq.top().second;
-        pq.pop();
+        atomic<int> next(0);
+        runOnAll([&](int worker)
+                 {
+            while (true)
+            {
+                int begin = next.fetch_add(grain);
+                if (begin >= n)
+                {
+                    break;
+                }
+                body(begin, min(n, begin + grain), worker);
+            } });
+    }
 
-        for (const DijEdge &edge : adjList[u])
-        {
-            int v = edge.dest;
-            int weight = edge.weight;
+private:
+    int count;
+    vector<thread> workers;
+    mutex m;
+    condition_variable wake, done;
+    const function<void(int)> *current = nullptr;
+    long long generation = 0;
+    int pending = 0;
+    bool stopping = false;
 
-            if (dist[u] + weight < dist[v])
+    void workerLoop(int id)
+    {
+        long long seen = 0;
+        while (true)
+        {
+            const function<void(int)> *task;
             {
-                dist[v] = dist[u] + weight;
-                pq.push({dist[v], v});
+                unique_lock<mutex> lock(m);
+                wake.wait(lock, [&]
+                          { return generation != seen; });
+                seen = generation;
+                if (stopping)
+                {
+                    return;
+                }
+                task = current;
+            }
+            (*task)(id);
+            {
+                lock_guard<mutex> lock(m);
+                if (--pending == 0)
+                {
+                    done.notify_one();
+                }
             }
         }
     }
+};
 
-    auto stop = high_resolution_clock::now();
-    auto duration = duration_cast<microseconds>(stop - start).count();
+// Per-worker task deques for independent tasks. A worker takes from the back
+// of its own deque and, once that is empty, steals from the front of the
+// others', so a worker stuck on expensive tasks hands the rest to idle ones.
+class WorkStealingQueues
+{
+public:
+    WorkStealingQueues(int workers) : queues(workers) {}
 
-    cout << "Time taken by Dijkstra's algorithm: " << duration << " microseconds" << endl;
+    // deals tasks out in contiguous blocks, one block per worker
+    void distribute(int count)
+    {
+        int workers = (int)queues.size();
+        for (int w = 0; w < workers; ++w)
+        {
+            int begin = (int)((long long)count * w / workers);
+            int end = (int)((long long)count * (w + 1) / workers);
+            for (int t = begin; t < end; ++t)
+            {
+                queues[w].tasks.push_back(t);
+            }
+        }
+    }
 
-    cout << "Shortest distances from user " << src << " to all other users:" << endl;
-    for (int i = 0; i < V; ++i)
+    bool pop(int worker, int &task)
     {
-        if (dist[i] == INT_MAX)
         {
-            cout << "User " << i << " is unreachable" << endl;
+            Queue &own = queues[worker];
+            lock_guard<mutex> lock(own.m);
+            if (!own.tasks.empty())
+            {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        int workers = (int)queues.size();
+        for (int i = 1; i < workers; ++i)
+        {
+            Queue &victim = queues[(worker + i) % workers];
+            lock_guard<mutex> lock(victim.m);
+            if (!victim.tasks.empty())
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                steals.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
         }
-        else
+        return false;
+    }
+
+    long long stealCount() const
+    {
+        return steals.load();
+    }
+
+private:
+    struct Queue
+    {
+        mutex m;
+        deque<int> tasks;
+    };
+    vector<Queue> queues;
+    atomic<long long> steals{0};
+};
+
+// worker threads for the parallel engines, set with --threads=
+int workerThreads = max(1, (int)thread::hardware_concurrency());
+
+// Lowers target to value if value is smaller; returns true if it did.
+inline bool atomicFetchMin(atomic<int> &target, int value)
+{
+    int old = target.load(memory_order_relaxed);
+    while (value < old)
+    {
+        if (target.compare_exchange_weak(old, value, memory_order_relaxed))
         {
-            cout << "To user " << i << " : " << dist[i] << endl;
+            return true;
         }
     }
+    return false;
 }
 
-// bellman-ford
-struct bellEdges
+// mapped files
+//
+// Read-only views of whole files, used by the text parsers and to serve
+// snapshot arrays in place. An IntArray either owns its ints or borrows them
+// from such a mapping; whoever keeps the MappedFile alive keeps the borrowed
+// arrays valid.
+class MappedFile
 {
-    int src, dest, weight;
+public:
+    const char *data = nullptr;
+    size_t size = 0;
+
+    MappedFile() {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile()
+    {
+        close();
+    }
+
+    bool open(const string &filename);
+    void close();
+    void adviseSequential();
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
 };
 
-class BellmanFordGraph
+#ifdef _WIN32
+bool MappedFile::open(const string &filename)
 {
-public:
-    int V, E;
-    vector<bellEdges> edges;
+    close();
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER bytes;
+    if (!GetFileSizeEx(file, &bytes))
+    {
+        close();
+        return false;
+    }
+    size = (size_t)bytes.QuadPart;
+    if (size == 0)
+    {
+        return true;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        close();
+        return false;
+    }
+    data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
 
-    BellmanFordGraph(int V, int E)
+void MappedFile::close()
+{
+    if (data != nullptr)
     {
-        this->V = V;
-        this->E = E;
-        edges.resize(E);
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
     }
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+}
 
-    void addEdge(int u, int v, int w, int i)
+void MappedFile::adviseSequential()
+{
+}
+#else
+bool MappedFile::open(const string &filename)
+{
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
     {
-        edges[i] = {u, v, w};
+        return false;
     }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    size = (size_t)info.st_size;
+    if (size > 0)
+    {
+        void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            size = 0;
+            return false;
+        }
+        data = (const char *)view;
+    }
+    ::close(fd); // the mapping keeps the file alive
+    return true;
+}
 
-    void bellmanFord(int src);
-};
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        munmap((void *)data, size);
+    }
+    data = nullptr;
+    size = 0;
+}
 
-void BellmanFordGraph::bellmanFord(int src)
+void MappedFile::adviseSequential()
 {
-    vector<int> dist(V, INT_MAX);
-    dist[src] = 0;
+    if (data != nullptr)
+    {
+        madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+}
+#endif
 
-    auto start = high_resolution_clock::now(); // Start measuring time
+class IntArray
+{
+public:
+    IntArray() {}
+    IntArray(const IntArray &other)
+    {
+        *this = other;
+    }
+    IntArray(IntArray &&other) noexcept
+    {
+        *this = move(other);
+    }
 
-    for (int i = 1; i <= V - 1; ++i)
+    IntArray &operator=(const IntArray &other)
     {
-        for (int j = 0; j < E; ++j)
+        if (this != &other)
         {
-            int u = edges[j].src;
-            int v = edges[j].dest;
-            int weight = edges[j].weight;
-            if (dist[u] != INT_MAX && dist[u] + weight < dist[v])
+            owned = other.owned;
+            isBorrowed = other.isBorrowed;
+            if (isBorrowed)
             {
-                dist[v] = dist[u] + weight;
+                ptr = other.ptr;
+                count = other.count;
+            }
+            else
+            {
+                adopt();
             }
         }
+        return *this;
     }
 
-    for (int j = 0; j < E; ++j)
+    IntArray &operator=(IntArray &&other) noexcept
     {
-        int u = edges[j].src;
-        int v = edges[j].dest;
-        int weight = edges[j].weight;
-        if (dist[u] != INT_MAX && dist[u] + weight < dist[v])
+        if (this != &other)
         {
-            cout << "Graph contains negative weight cycle" << endl;
-            return;
+            owned = move(other.owned);
+            isBorrowed = other.isBorrowed;
+            ptr = isBorrowed ? other.ptr : owned.data();
+            count = isBorrowed ? other.count : owned.size();
+            other.clear();
         }
+        return *this;
     }
 
-    auto stop = high_resolution_clock::now();
-    auto duration = duration_cast<microseconds>(stop - start).count();
+    void assign(size_t n, int value)
+    {
+        owned.assign(n, value);
+        adopt();
+    }
 
-    cout << "Time taken by Bellman-Ford algorithm: " << duration << " microseconds" << endl;
+    void assign(vector<int> &&values)
+    {
+        owned = move(values);
+        adopt();
+    }
 
-    cout << "Shortest distances from location " << src << ":" << endl;
-    for (int i = 0; i < V; ++i)
+    // growing or shrinking a borrowed array makes an owned copy first
+    void resize(size_t n)
     {
-        if (dist[i] == INT_MAX)
-        {
-            cout << "Location " << i << " is unreachable" << endl;
-        }
-        else
+        if (isBorrowed)
         {
-            cout << "To location " << i << " : " << dist[i] << " units" << endl;
+            owned.assign(ptr, ptr + min(n, count));
         }
+        owned.resize(n);
+        adopt();
     }
-}
 
-// bellman-ford
-void inputMapManually(BellmanFordGraph &g)
-{
-    int V, E;
-    cout << "Enter the number of locations: ";
-    cin >> V;
-
-    if (V <= 0)
+    void borrow(const int *values, size_t n)
     {
-        cout << "Number of locations must be a positive integer." << endl;
-        return;
+        vector<int>().swap(owned);
+        ptr = const_cast<int *>(values); // mapped read-only; borrowed arrays are never written
+        count = n;
+        isBorrowed = true;
     }
 
-    cout << "Enter the number of roads: ";
-    cin >> E;
-
-    if (E < 0)
+    void clear()
     {
-        cout << "Number of roads must be a non-negative integer." << endl;
-        return;
+        vector<int>().swap(owned);
+        adopt();
     }
 
-    g = BellmanFordGraph(V, E);
-
-    for (int i = 0; i < E; ++i)
+    bool borrowed() const
     {
-        int u, v, w;
-        cout << "Road " << i + 1 << " (start end distance): ";
-        cin >> u >> v >> w;
-
-        if (u < 0 || u >= V || v < 0 || v >= V)
-        {
-            cout << "Invalid road. Location indices must be between 0 and " << V - 1 << "." << endl;
-            return;
-        }
-
-        g.addEdge(u, v, w, i);
+        return isBorrowed;
+    }
+    size_t size() const
+    {
+        return count;
+    }
+    bool empty() const
+    {
+        return count == 0;
+    }
+    int *data()
+    {
+        return ptr;
+    }
+    const int *data() const
+    {
+        return ptr;
+    }
+    int &operator[](size_t i)
+    {
+        return ptr[i];
+    }
+    const int &operator[](size_t i) const
+    {
+        return ptr[i];
+    }
+    int *begin()
+    {
+        return ptr;
+    }
+    int *end()
+    {
+        return ptr + count;
+    }
+    const int *begin() const
+    {
+        return ptr;
+    }
+    const int *end() const
+    {
+        return ptr + count;
     }
 
-    int src;
-    cout << "Enter the starting location: ";
-    cin >> src;
+private:
+    vector<int> owned;
+    int *ptr = nullptr;
+    size_t count = 0;
+    bool isBorrowed = false;
 
-    if (src < 0 || src >= V)
+    void adopt()
     {
-        cout << "Invalid starting location." << endl;
-        return;
+        ptr = owned.data();
+        count = owned.size();
+        isBorrowed = false;
     }
+};
 
-    g.bellmanFord(src);
-}
+// result output
+//
+// Solvers fill a distance array; a ResultSink renders it. All sinks write
+// through a BufferedWriter, which formats into a 1 MB buffer (integers with
+// to_chars) and hands it to the file descriptor in large write() calls, so
+// printing millions of vertices costs a few syscalls instead of a flush per
+// line. --output= picks the sink for dijkstra() and bellmanFord():
+//
+//   text       "To user 3 : 17" per vertex, the interactive format
+//   reachable  "3 17" per reachable vertex only
+//   binary     the raw distance array, V native-endian int32 values with
+//              INT_MAX for unreachable vertices
+//
+// and --output-file=FILE sends it to FILE instead of stdout. The file is
+// truncated by the first query of a run and later queries append to it.
+// Binary output needs --output-file, since the menus print text to stdout.
+enum class OutputFormat
+{
+    Text,
+    Reachable,
+    Binary
+};
 
-void loadMapFromFile(BellmanFordGraph &g)
+OutputFormat selectedOutput = OutputFormat::Text;
+string outputFile;
+
+bool parseOutputFormat(const string &name, OutputFormat &format)
 {
-    string filename = "bellManFord.txt";
+    if (name == "text")
+        format = OutputFormat::Text;
+    else if (name == "reachable")
+        format = OutputFormat::Reachable;
+    else if (name == "binary")
+        format = OutputFormat::Binary;
+    else
+        return false;
+    return true;
+}
 
-    ifstream file(filename);
-    if (!file)
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(int fd) : fd(fd), buffer(1 << 20) {}
+    ~BufferedWriter()
     {
-        cerr << "Unable to open file " << filename << endl;
-        exit(1);
+        flush();
+        if (owned)
+        {
+#ifdef _WIN32
+            _close(fd);
+#else
+            ::close(fd);
+#endif
+        }
     }
 
-    int V, E;
-    file >> V >> E;
-
-    if (V <= 0 || E < 0)
+    // Switches to filename, truncated or appended to, closed by the destructor.
+    bool open(const string &filename, bool append = false)
     {
-        cout << "Invalid number of locations or roads in the file." << endl;
-        return;
+        flush();
+#ifdef _WIN32
+        int mode = _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC);
+        int file = _open(filename.c_str(), mode, _S_IREAD | _S_IWRITE);
+#else
+        int file = ::open(filename.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+#endif
+        if (file < 0)
+        {
+            cerr << "Unable to open file " << filename << endl;
+            return false;
+        }
+        fd = file;
+        owned = true;
+        return true;
     }
 
-    g = BellmanFordGraph(V, E);
-
-    for (int i = 0; i < E; ++i)
+    void text(string_view s)
     {
-        int u, v, w;
-        file >> u >> v >> w;
+        bytes(s.data(), s.size());
+    }
 
-        if (u < 0 || u >= V || v < 0 || v >= V)
+    void bytes(const void *data, size_t count)
+    {
+        if (count > buffer.size())
         {
-            cout << "Invalid road in the file. Location indices must be between 0 and " << V - 1 << "." << endl;
+            flush();
+            writeAll((const char *)data, count);
             return;
         }
-
-        g.addEdge(u, v, w, i);
+        reserve(count);
+        memcpy(buffer.data() + used, data, count);
+        used += count;
     }
 
-    file.close();
-
-    int src;
-    cout << "Enter the starting location: ";
-    cin >> src;
+    void number(long long value)
+    {
+        reserve(24);
+        used = to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+    }
 
-    if (src < 0 || src >= V)
+    void distance(int d)
     {
-        cout << "Invalid starting location." << endl;
-        return;
+        if (d == INT_MAX)
+        {
+            text("inf");
+        }
+        else
+        {
+            number(d);
+        }
     }
 
-    g.bellmanFord(src);
-}
+    void space()
+    {
+        text(" ");
+    }
 
-void displayBellmenFord()
+    void endLine()
+    {
+        text("\n");
+    }
+
+    void flush()
+    {
+        writeAll(buffer.data(), used);
+        used = 0;
+    }
+
+private:
+    int fd;
+    bool owned = false;
+    vector<char> buffer;
+    size_t used = 0;
+
+    void reserve(size_t bytes)
+    {
+        if (used + bytes > buffer.size())
+        {
+            flush();
+        }
+    }
+
+    void writeAll(const char *data, size_t count)
+    {
+        while (count > 0)
+        {
+#ifdef _WIN32
+            int written = _write(fd, data, (unsigned)min(count, (size_t)1 << 30));
+#else
+            ssize_t written = ::write(fd, data, count);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            if (written <= 0)
+            {
+                return; // reader went away, drop the rest
+            }
+            data += written;
+            count -= written;
+        }
+    }
+};
+
+class ResultSink
 {
-    cout << "Main Menu:" << endl;
-    cout << "1. Input map manually" << endl;
-    cout << "2. Load map from file" << endl;
-    cout << "3. Back to main " << endl;
-}
+public:
+    virtual ~ResultSink() = default;
+    // dist[v] is INT_MAX for vertices src does not reach
+    virtual void write(int src, const vector<int> &dist) = 0;
+};
 
-// dijkstra
-void inputGraphManually()
+// The interactive listing, e.g. noun "location" and unit " units" give
+// "Location 4 is unreachable" and "To location 5 : 12 units".
+class TextSink : public ResultSink
 {
-    int V, E;
-    cout << "Enter the number of users (vertices): ";
-    cin >> V;
+public:
+    TextSink(BufferedWriter &out, const string &heading, const string &noun, const string &unit)
+        : out(out), heading(heading), noun(noun), unit(unit)
+    {
+        capitalNoun = noun;
+        capitalNoun[0] = (char)toupper((unsigned char)capitalNoun[0]);
+    }
 
-    cout << "Enter the number of connections (edges): ";
-    cin >> E;
+    void write(int src, const vector<int> &dist) override
+    {
+        (void)src;
+        out.text(heading);
+        out.endLine();
+        for (size_t i = 0; i < dist.size(); ++i)
+        {
+            if (dist[i] == INT_MAX)
+            {
+                out.text(capitalNoun);
+                out.space();
+                out.number(i);
+                out.text(" is unreachable\n");
+            }
+            else
+            {
+                out.text("To ");
+                out.text(noun);
+                out.space();
+                out.number(i);
+                out.text(" : ");
+                out.number(dist[i]);
+                out.text(unit);
+                out.endLine();
+            }
+        }
+    }
 
-    DijkstraGraph g(V);
+private:
+    BufferedWriter &out;
+    string heading, noun, capitalNoun, unit;
+};
 
-    for (int i = 0; i < E; ++i)
+// "vertex distance" lines for reachable vertices only
+class ReachableSink : public ResultSink
+{
+public:
+    explicit ReachableSink(BufferedWriter &out) : out(out) {}
+
+    void write(int src, const vector<int> &dist) override
     {
-        int u, v, w;
-        cout << "Connection " << i + 1 << " (user1 user2 weight): ";
-        cin >> u >> v >> w;
-        g.addEdge(u, v, w);
+        (void)src;
+        for (size_t i = 0; i < dist.size(); ++i)
+        {
+            if (dist[i] != INT_MAX)
+            {
+                out.number(i);
+                out.space();
+                out.number(dist[i]);
+                out.endLine();
+            }
+        }
     }
 
-    int src;
-    cout << "Enter the source user: ";
-    cin >> src;
+private:
+    BufferedWriter &out;
+};
+
+class BinarySink : public ResultSink
+{
+public:
+    explicit BinarySink(BufferedWriter &out) : out(out) {}
+
+    void write(int src, const vector<int> &dist) override
+    {
+        (void)src;
+        out.bytes(dist.data(), dist.size() * sizeof(int));
+    }
+
+private:
+    BufferedWriter &out;
+};
+
+// Renders dist with the selected sink to stdout or the selected file. cout is
+// flushed first so the result lands after anything already printed.
+void renderResult(int src, const vector<int> &dist, const string &heading, const string &noun, const string &unit)
+{
+    static bool fileStarted = false; // later queries of the run append
+    cout.flush();
+    BufferedWriter out(1);
+    if (!outputFile.empty())
+    {
+        if (!out.open(outputFile, fileStarted))
+        {
+            return;
+        }
+        fileStarted = true;
+    }
 
-    g.dijkstra(src);
+    unique_ptr<ResultSink> sink;
+    switch (selectedOutput)
+    {
+    case OutputFormat::Reachable:
+        sink = make_unique<ReachableSink>(out);
+        break;
+    case OutputFormat::Binary:
+        sink = make_unique<BinarySink>(out);
+        break;
+    case OutputFormat::Text:
+    default:
+        sink = make_unique<TextSink>(out, heading, noun, unit);
+        break;
+    }
+    sink->write(src, dist);
 }
 
-void loadGraphFromFile()
+// instrumentation
+//
+// Counters bumped once per edge or per queue operation go through
+// SSSP_COUNT, so building with -DSSSP_STATS=0 takes them out of the inner
+// loops (they then read zero). Counters bumped once per round stay on since
+// the negative cycle checks rely on them. PhaseTimes splits a query into
+// load, build (CSR or edge index), solve and output; with --stats-json every
+// dijkstra() and bellmanFord() call appends them and the counters to
+// queryStatsLog as one JSON line.
+#ifndef SSSP_STATS
+#define SSSP_STATS 1
+#endif
+#if SSSP_STATS
+#define SSSP_COUNT(counter, amount) ((counter) += (amount))
+#else
+#define SSSP_COUNT(counter, amount) ((void)(counter), (void)(amount))
+#endif
+
+// microseconds spent in each phase of the last query
+struct PhaseTimes
+{
+    long long load = 0;
+    long long build = 0;
+    long long solve = 0;
+    long long output = 0;
+};
+
+FILE *queryStatsLog = nullptr;
+
+long long microsSince(high_resolution_clock::time_point start)
 {
-    const string filename = "dijkstraInput.txt";
+    return duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+}
 
-    ifstream file(filename);
-    if (!file)
+// Writes {"engine": ..., fields..., "load_us": ...} as one line. fields is
+// a list of already formatted "key": value pairs.
+void logQueryStats(const string &engine, const string &variant, int src, const string &fields,
+                   const PhaseTimes &phases)
+{
+    if (!queryStatsLog)
     {
-        cerr << "Unable to open file " << filename << endl;
-        return; // Return gracefully if file cannot be opened
+        return;
     }
+    ostringstream line;
+    line << "{\"engine\": \"" << engine << "\", \"variant\": \"" << variant << "\", \"source\": " << src
+         << ", \"stats\": " << (SSSP_STATS ? "true" : "false") << fields << ", \"load_us\": " << phases.load
+         << ", \"build_us\": " << phases.build << ", \"solve_us\": " << phases.solve
+         << ", \"output_us\": " << phases.output << "}\n";
+    fputs(line.str().c_str(), queryStatsLog);
+    fflush(queryStatsLog);
+}
 
-    int V, E;
-    file >> V >> E;
-    DijkstraGraph g(V);
+// result cache
+//
+// Remembers one-to-all distance arrays per (graph version, source,
+// algorithm) so hot sources are answered without searching again. Entries
+// are compressed: only reachable vertices store a distance, indexed either by
+// a sorted vertex list or, when more than 1/32 of the vertices are reached, by
+// a bitmap. The least recently used entries are evicted to stay within the
+// byte budget (--cache-mb=, 0 turns the cache off). Graphs bump their version
+// and clear their cache on every addEdge, so a stale entry is never served.
+enum class SsspAlgorithm : uint8_t
+{
+    Dijkstra,
+    DeltaStepping,
+    BellmanFord
+};
 
-    for (int i = 0; i < E; ++i)
+size_t resultCacheBytes = 64 << 20;
+
+struct CacheStats
+{
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+    long long invalidations = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budget = 0;
+};
+
+class SsspCache
+{
+public:
+    explicit SsspCache(size_t budget = resultCacheBytes) : budget(budget) {}
+
+    // Copies start out empty; the list iterators in index cannot be shared.
+    SsspCache(const SsspCache &other) : budget(other.budget) {}
+    SsspCache &operator=(const SsspCache &other)
     {
-        int u, v, w;
-        file >> u >> v >> w;
-        g.addEdge(u, v, w);
+        clear();
+        budget = other.budget;
+        return *this;
     }
+    SsspCache(SsspCache &&) = default;
+    SsspCache &operator=(SsspCache &&) = default;
 
-    file.close();
+    bool lookup(uint64_t version, int src, SsspAlgorithm algorithm, vector<int> &dist);
+    void store(uint64_t version, int src, SsspAlgorithm algorithm, const vector<int> &dist);
+    void clear();
+    CacheStats stats() const;
 
-    int src;
-    cout << "Enter the source user: ";
-    cin >> src;
+private:
+    struct Key
+    {
+        uint64_t version;
+        int src;
+        SsspAlgorithm algorithm;
 
-    g.dijkstra(src);
-}
+        bool operator==(const Key &other) const
+        {
+            return version == other.version && src == other.src && algorithm == other.algorithm;
+        }
+    };
 
-void displayDijkstraMenu()
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            return hash<uint64_t>()(key.version * 0x9E3779B97F4A7C15ULL ^ (uint64_t)key.src << 8 ^ (uint64_t)key.algorithm);
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        int V;
+        vector<int> vertices;     // sorted reachable vertices, if sparse
+        vector<uint64_t> reached; // reachability bitmap, if dense
+        vector<int> values;       // distances of the reachable vertices in order
+        size_t bytes;
+    };
+
+    size_t budget;
+    size_t used = 0;
+    long long hits = 0, misses = 0, evictions = 0, invalidations = 0;
+    list<Entry> entries; // most recently used first
+    unordered_map<Key, list<Entry>::iterator, KeyHash> index;
+};
+
+bool SsspCache::lookup(uint64_t version, int src, SsspAlgorithm algorithm, vector<int> &dist)
 {
-    cout << "Dijkstra's Menu:" << endl;
-    cout << "1. Input social network manually" << endl;
-    cout << "2. Input social network from file" << endl;
-    cout << "3. Back to main menu" << endl;
+    auto found = index.find({version, src, algorithm});
+    if (found == index.end())
+    {
+        ++misses;
+        return false;
+    }
+    ++hits;
+    entries.splice(entries.begin(), entries, found->second);
+
+    const Entry &entry = *found->second;
+    dist.assign(entry.V, INT_MAX);
+    if (!entry.reached.empty())
+    {
+        size_t next = 0;
+        for (size_t word = 0; word < entry.reached.size(); ++word)
+        {
+            for (uint64_t bits = entry.reached[word]; bits; bits &= bits - 1)
+            {
+                dist[word * 64 + __builtin_ctzll(bits)] = entry.values[next++];
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < entry.vertices.size(); ++i)
+        {
+            dist[entry.vertices[i]] = entry.values[i];
+        }
+    }
+    return true;
 }
 
-// bellman ford main
-void bellmanfordMain()
+void SsspCache::store(uint64_t version, int src, SsspAlgorithm algorithm, const vector<int> &dist)
 {
-    while (true)
+    Key key{version, src, algorithm};
+    if (budget == 0 || index.count(key))
     {
-        displayBellmenFord();
-        int choice;
-        cout << "Enter your choice: ";
-        cin >> choice;
-        system("cls");
-        BellmanFordGraph g(0, 0);
-        switch (choice)
+        return;
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.V = (int)dist.size();
+    size_t reachable = 0;
+    for (int d : dist)
+    {
+        reachable += d != INT_MAX;
+    }
+    entry.values.reserve(reachable);
+    if (reachable * 32 > dist.size())
+    {
+        entry.reached.assign((dist.size() + 63) / 64, 0);
+    }
+    else
+    {
+        entry.vertices.reserve(reachable);
+    }
+    for (size_t v = 0; v < dist.size(); ++v)
+    {
+        if (dist[v] == INT_MAX)
         {
-        case 1:
-            inputMapManually(g);
-            break;
-        case 2:
-            loadMapFromFile(g);
-            break;
-        case 3:
-            cout << "Exiting..." << endl;
-            return;
-        default:
-            cout << "Invalid choice. Please try again." << endl;
             continue;
         }
+        if (entry.reached.empty())
+        {
+            entry.vertices.push_back((int)v);
+        }
+        else
+        {
+            entry.reached[v / 64] |= 1ULL << (v % 64);
+        }
+        entry.values.push_back(dist[v]);
+    }
+    entry.bytes = sizeof(Entry) + 64 + (entry.vertices.size() + entry.values.size()) * sizeof(int) +
+                  entry.reached.size() * sizeof(uint64_t);
+    if (entry.bytes > budget)
+    {
+        return;
     }
+
+    while (used + entry.bytes > budget)
+    {
+        used -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++evictions;
+    }
+    used += entry.bytes;
+    entries.push_front(move(entry));
+    index[key] = entries.begin();
 }
 
-void dijkstraMain()
+void SsspCache::clear()
 {
-    while (true)
+    if (entries.empty())
     {
-        displayDijkstraMenu();
+        return;
+    }
+    ++invalidations;
+    entries.clear();
+    index.clear();
+    used = 0;
+}
 
-        int ch;
-        cout << "Enter your choice: ";
-        cin >> ch;
-        system("cls");
-        switch (ch)
+CacheStats SsspCache::stats() const
+{
+    CacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.evictions = evictions;
+    s.invalidations = invalidations;
+    s.entries = entries.size();
+    s.bytes = used;
+    s.budget = budget;
+    return s;
+}
+
+void printCacheStats(const CacheStats &stats)
+{
+    long long lookups = stats.hits + stats.misses;
+    cout << "Result cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+         << (lookups ? stats.hits * 100 / lookups : 0) << "% hit rate), " << stats.entries << " entries in "
+         << stats.bytes / 1024 << " of " << stats.budget / 1024 << " KB, " << stats.evictions << " evictions, "
+         << stats.invalidations << " invalidations" << endl;
+}
+
+// predecessor trees
+//
+// parent[v] is the vertex before v on a shortest path from src, -1 for src
+// itself and for unreachable vertices: 4 bytes per vertex next to dist,
+// filled only when a caller asks for routes. path() walks the parents back
+// from the target and reverses, so a route costs O(its length); paths()
+// does the same for many targets into one contiguous buffer.
+struct PredecessorTree
+{
+    int src = -1;
+    vector<int> parent;
+
+    bool reaches(int v) const
+    {
+        return v == src || parent[v] >= 0;
+    }
+
+    // src ... target, empty when target is unreachable
+    void path(int target, vector<int> &route) const
+    {
+        route.clear();
+        append(target, route);
+    }
+
+    // Route i is vertices[offsets[i], offsets[i + 1]).
+    void paths(const vector<int> &targets, vector<int> &vertices, vector<int> &offsets) const
+    {
+        vertices.clear();
+        offsets.assign(1, 0);
+        for (int target : targets)
+        {
+            append(target, vertices);
+            offsets.push_back((int)vertices.size());
+        }
+    }
+
+private:
+    void append(int target, vector<int> &vertices) const
+    {
+        if (!reaches(target))
         {
-        case 1:
-            inputGraphManually();
-            break;
-        case 2:
-            loadGraphFromFile();
-            break;
-        case 3:
             return;
-        default:
-            cout << "Invalid choice. Please try again." << endl;
-            continue;
         }
+        size_t first = vertices.size();
+        for (int v = target; v != -1; v = parent[v])
+        {
+            vertices.push_back(v);
+        }
+        reverse(vertices.begin() + first, vertices.end());
+    }
+};
+
+// priority queues for dijkstra
+//
+// Every queue has the same interface so DijkstraGraph::run can take it as a
+// template parameter: reset(V) before a query, push(v, d) inserts v or lowers
+// its key, pop(d) removes the minimum and returns its vertex with the key in d.
+// Queues without decrease-key may hand back outdated entries; run() skips
+// those by comparing d with dist[v].
+struct QueueStats
+{
+    long long pushes = 0;
+    long long pops = 0;
+    long long stalePops = 0;
+    long long edgesScanned = 0; // filled in by DijkstraGraph::run
+    long long relaxations = 0;
+};
+
+enum class QueueKind
+{
+    Auto,
+    Lazy,
+    FourAry,
+    Pairing,
+    Dial,
+    Radix
+};
+
+const QueueKind allQueues[] = {QueueKind::Lazy, QueueKind::FourAry, QueueKind::Pairing, QueueKind::Dial, QueueKind::Radix};
+
+string queueName(QueueKind kind)
+{
+    switch (kind)
+    {
+    case QueueKind::Auto:
+        return "auto";
+    case QueueKind::Lazy:
+        return "lazy binary heap";
+    case QueueKind::FourAry:
+        return "indexed 4-ary heap";
+    case QueueKind::Pairing:
+        return "pairing heap";
+    case QueueKind::Dial:
+        return "dial buckets";
+    case QueueKind::Radix:
+        return "radix heap";
     }
+    return "unknown";
+}
+
+// names accepted by --queue=
+bool parseQueueName(const string &name, QueueKind &kind)
+{
+    if (name == "auto")
+        kind = QueueKind::Auto;
+    else if (name == "lazy")
+        kind = QueueKind::Lazy;
+    else if (name == "4ary")
+        kind = QueueKind::FourAry;
+    else if (name == "pairing")
+        kind = QueueKind::Pairing;
+    else if (name == "dial")
+        kind = QueueKind::Dial;
+    else if (name == "radix")
+        kind = QueueKind::Radix;
+    else
+        return false;
+    return true;
 }
 
-int main()
+// std::priority_queue without decrease-key, every improvement is a new entry
+class LazyHeap
 {
+public:
+    QueueStats stats;
+
+    void reset(int V)
+    {
+        (void)V;
+        pq = decltype(pq)();
+        stats = QueueStats();
+    }
+
+    bool empty() const
+    {
+        return pq.empty();
+    }
+
+    void push(int v, int d)
+    {
+        pq.push({d, v});
+        SSSP_COUNT(stats.pushes, 1);
+    }
+
+    int pop(int &d)
+    {
+        d = pq.top().first;
+        int v = pq.top().second;
+        pq.pop();
+        SSSP_COUNT(stats.pops, 1);
+        return v;
+    }
+
+private:
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+};
+
+// Indexed 4-ary heap with decrease-key. Keys are packed as (dist << 32) | vertex
+// so a single 64-bit compare orders by distance and breaks ties by vertex.
+class FourAryHeap
+{
+public:
+    QueueStats stats;
+
+    void reset(int V)
+    {
+        heap.clear();
+        pos.assign(V, -1);
+        stats = QueueStats();
+    }
+
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    int topKey() const
+    {
+        return (int)(heap[0] >> 32);
+    }
+
+    // empties the heap in time proportional to its size, unlike reset(V)
+    void clear()
+    {
+        for (uint64_t key : heap)
+        {
+            pos[(uint32_t)key] = -1;
+        }
+        heap.clear();
+    }
+
+    void push(int v, int d)
+    {
+        uint64_t key = pack(v, d);
+        int i = pos[v];
+        if (i < 0)
+        {
+            i = (int)heap.size();
+            heap.push_back(key);
+        }
+        else if (key >= heap[i])
+        {
+            return;
+        }
+        siftUp(i, key);
+        SSSP_COUNT(stats.pushes, 1);
+    }
+
+    int pop(int &d)
+    {
+        uint64_t top = heap[0];
+        uint64_t last = heap.back();
+        heap.pop_back();
+        int v = (int)(uint32_t)top;
+        pos[v] = -1;
+        if (!heap.empty())
+        {
+            siftDown(0, last);
+        }
+        d = (int)(top >> 32);
+        SSSP_COUNT(stats.pops, 1);
+        return v;
+    }
+
+private:
+    vector<uint64_t> heap;
+    vector<int> pos;
+
+    static uint64_t pack(int v, int d)
+    {
+        return ((uint64_t)(uint32_t)d << 32) | (uint32_t)v;
+    }
+
+    void place(int i, uint64_t key)
+    {
+        heap[i] = key;
+        pos[(uint32_t)key] = i;
+    }
+
+    void siftUp(int i, uint64_t key)
+    {
+        while (i > 0)
+        {
+            int parent = (i - 1) >> 2;
+            if (heap[parent] <= key)
+            {
+                break;
+            }
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, key);
+    }
+
+    void siftDown(int i, uint64_t key)
+    {
+        int n = (int)heap.size();
+        while (true)
+        {
+            int first = (i << 2) + 1;
+            if (first >= n)
+            {
+                break;
+            }
+            int last = min(first + 4, n);
+            int best = first;
+            for (int c = first + 1; c < last; ++c)
+            {
+                if (heap[c] < heap[best])
+                {
+                    best = c;
+                }
+            }
+            if (heap[best] >= key)
+            {
+                break;
+            }
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, key);
+    }
+};
+
+// Pairing heap with one node per vertex. prev points at the parent for a
+// leftmost child and at the left sibling otherwise, which lets decrease-key
+// cut a node out in O(1).
+class PairingHeap
+{
+public:
+    QueueStats stats;
+
+    void reset(int V)
+    {
+        key.assign(V, 0);
+        child.assign(V, -1);
+        sibling.assign(V, -1);
+        prev.assign(V, -1);
+        inHeap.assign(V, 0);
+        root = -1;
+        stats = QueueStats();
+    }
+
+    bool empty() const
+    {
+        return root < 0;
+    }
+
+    void push(int v, int d)
+    {
+        if (!inHeap[v])
+        {
+            inHeap[v] = 1;
+            key[v] = d;
+            child[v] = sibling[v] = prev[v] = -1;
+            root = root < 0 ? v : meld(root, v);
+        }
+        else
+        {
+            if (d >= key[v])
+            {
+                return;
+            }
+            key[v] = d;
+            if (v != root)
+            {
+                cut(v);
+                root = meld(root, v);
+            }
+        }
+        SSSP_COUNT(stats.pushes, 1);
+    }
+
+    int pop(int &d)
+    {
+        int v = root;
+        d = key[v];
+        inHeap[v] = 0;
+        root = mergePairs(child[v]);
+        SSSP_COUNT(stats.pops, 1);
+        return v;
+    }
+
+private:
+    vector<int> key, child, sibling, prev;
+    vector<char> inHeap;
+    vector<int> pairs;
+    int root = -1;
+
+    int meld(int a, int b)
+    {
+        if (key[b] < key[a] || (key[b] == key[a] && b < a))
+        {
+            swap(a, b);
+        }
+        // b becomes the leftmost child of a
+        sibling[b] = child[a];
+        if (child[a] >= 0)
+        {
+            prev[child[a]] = b;
+        }
+        prev[b] = a;
+        child[a] = b;
+        sibling[a] = -1;
+        prev[a] = -1;
+        return a;
+    }
+
+    void cut(int v)
+    {
+        int p = prev[v];
+        if (child[p] == v)
+        {
+            child[p] = sibling[v];
+        }
+        else
+        {
+            sibling[p] = sibling[v];
+        }
+        if (sibling[v] >= 0)
+        {
+            prev[sibling[v]] = p;
+        }
+        sibling[v] = prev[v] = -1;
+    }
+
+    // standard two-pass merge: pair up left to right, then fold right to left
+    int mergePairs(int first)
+    {
+        if (first < 0)
+        {
+            return -1;
+        }
+        pairs.clear();
+        while (first >= 0)
+        {
+            int a = first;
+            int b = sibling[a];
+            first = b >= 0 ? sibling[b] : -1;
+            sibling[a] = prev[a] = -1;
+            if (b >= 0)
+            {
+                sibling[b] = prev[b] = -1;
+                a = meld(a, b);
+            }
+            pairs.push_back(a);
+        }
+        int merged = pairs.back();
+        for (int i = (int)pairs.size() - 2; i >= 0; --i)
+        {
+            merged = meld(pairs[i], merged);
+        }
+        return merged;
+    }
+};
+
+// Dial's algorithm: one bucket per distance modulo maxWeight + 1. Valid for
+// non-negative integer weights, where every queued key lies in
+// [current, current + maxWeight]. Outdated entries are left in their bucket.
+class DialBuckets
+{
+public:
+    QueueStats stats;
+
+    DialBuckets(int maxWeight) : buckets(maxWeight + 1) {}
+
+    void reset(int V)
+    {
+        (void)V;
+        for (vector<int> &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        current = 0;
+        count = 0;
+        stats = QueueStats();
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    void push(int v, int d)
+    {
+        buckets[d % buckets.size()].push_back(v);
+        ++count;
+        SSSP_COUNT(stats.pushes, 1);
+    }
+
+    int pop(int &d)
+    {
+        while (buckets[current % buckets.size()].empty())
+        {
+            ++current;
+        }
+        vector<int> &bucket = buckets[current % buckets.size()];
+        int v = bucket.back();
+        bucket.pop_back();
+        --count;
+        d = (int)current;
+        SSSP_COUNT(stats.pops, 1);
+        return v;
+    }
+
+private:
+    vector<vector<int>> buckets;
+    long long current = 0;
+    long long count = 0;
+};
+
+// number of significant bits in x, 0 for x == 0
+inline int bitWidth(uint32_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return x == 0 ? 0 : 32 - __builtin_clz(x);
+#else
+    int bits = 0;
+    while (x)
+    {
+        ++bits;
+        x >>= 1;
+    }
+    return bits;
+#endif
+}
+
+// Radix heap for monotone integer keys. Bucket i holds keys whose highest bit
+// differing from the last popped key is bit i - 1; bucket 0 holds keys equal
+// to it. Each key moves down at most 32 times, so operations are O(log C)
+// amortized without comparisons between arbitrary keys.
+class RadixHeap
+{
+public:
+    QueueStats stats;
+
+    void reset(int V)
+    {
+        (void)V;
+        for (vector<pair<uint32_t, int>> &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        last = 0;
+        count = 0;
+        stats = QueueStats();
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    void push(int v, int d)
+    {
+        buckets[bitWidth((uint32_t)d ^ last)].push_back({(uint32_t)d, v});
+        ++count;
+        SSSP_COUNT(stats.pushes, 1);
+    }
+
+    int pop(int &d)
+    {
+        if (buckets[0].empty())
+        {
+            int i = 1;
+            while (buckets[i].empty())
+            {
+                ++i;
+            }
+            uint32_t smallest = UINT32_MAX;
+            for (const pair<uint32_t, int> &entry : buckets[i])
+            {
+                smallest = min(smallest, entry.first);
+            }
+            last = smallest;
+            for (const pair<uint32_t, int> &entry : buckets[i])
+            {
+                buckets[bitWidth(entry.first ^ last)].push_back(entry);
+            }
+            buckets[i].clear();
+        }
+        int v = buckets[0].back().second;
+        buckets[0].pop_back();
+        --count;
+        d = (int)last;
+        SSSP_COUNT(stats.pops, 1);
+        return v;
+    }
+
+private:
+    vector<pair<uint32_t, int>> buckets[33];
+    uint32_t last = 0;
+    long long count = 0;
+};
+
+// Largest maximum edge weight for which auto mode prefers Dial's buckets; the
+// bucket array is scanned once per distinct distance, so it has to stay small.
+// Forcing Dial is still allowed up to DIAL_LIMIT_WEIGHT buckets.
+const int DIAL_MAX_WEIGHT = 1024;
+const int DIAL_LIMIT_WEIGHT = 1 << 22;
+
+// queue used by DijkstraGraph::dijkstra, chosen from the Dijkstra menu or --queue=
+QueueKind selectedQueue = QueueKind::Auto;
+
+// Receives one finished source of a batch. Calls are serialized, and dist is
+// the worker's buffer, so it is only valid during the call.
+using BatchCallback = function<void(int src, const vector<int> &dist)>;
+
+struct BatchStats
+{
+    long long queries = 0;
+    long long steals = 0;
+    long long micros = 0;
+};
+
+// vertices settled by a point-to-point query in each direction
+struct PointQueryStats
+{
+    long long forwardSettled = 0;
+    long long backwardSettled = 0;
+    long long edgesScanned = 0;
+};
+
+// dijkstra's
+struct DijEdge
+{
+    int dest, weight;
+};
+
+// when DijkstraGraph::boundedSearch may stop; the defaults never stop it
+struct SearchLimit
+{
+    int target = -1;
+    int k = INT_MAX;
+    int radius = INT_MAX;
+};
+
+struct SettledVertex
+{
+    int v, dist;
+};
+
+class DijkstraGraph
+{
+public:
+    int V;
+    vector<vector<DijEdge>> adjList; // mutable builder, released by freeze()
+
+    // frozen CSR form: the edges leaving u are [offsets[u], offsets[u + 1])
+    IntArray offsets;
+    IntArray edgeDest;
+    IntArray edgeWeight;
+    bool frozen;
+
+    // reverse CSR built alongside: the edges entering v are [revOffsets[v], revOffsets[v + 1])
+    IntArray revOffsets;
+    IntArray revSrc;
+    IntArray revWeight;
+
+    // snapshot the CSR arrays borrow from, if the graph was loaded from one
+    shared_ptr<MappedFile> mapping;
+
+    // weight range of the frozen graph, used to pick a queue in auto mode
+    int minWeight, maxWeight;
+
+    PhaseTimes phases;
+
+    // bumped by every change to the edges; part of the result cache key
+    uint64_t version = 0;
+    SsspCache cache;
+
+    DijkstraGraph(int V)
+    {
+        this->V = V;
+        adjList.resize(V);
+        frozen = false;
+        minWeight = maxWeight = 0;
+    }
+
+    void addEdge(int u, int v, int weight)
+    {
+        if (frozen)
+        {
+            thaw();
+        }
+        adjList[u].push_back({v, weight});
+        ++version;
+        cache.clear();
+    }
+
+    void freeze();
+    void thaw();
+    template <class EdgeList>
+    void freezeFrom(const EdgeList &edges);
+
+    QueueKind resolveQueue(QueueKind kind) const;
+
+    template <bool TrackParents = false, class Queue>
+    void run(int src, vector<int> &dist, Queue &pq, bool reverse = false, PredecessorTree *tree = nullptr);
+    QueueStats shortestPaths(int src, QueueKind kind, vector<int> &dist, bool reverse = false,
+                             PredecessorTree *tree = nullptr);
+    int defaultDelta() const;
+    void deltaStepping(int src, vector<int> &dist, ThreadPool &pool, int delta = 0);
+    int query(int src, int dst, PointQueryStats &stats);
+    bool boundedSearch(int src, const SearchLimit &limit, vector<SettledVertex> &settled, QueueStats &stats);
+    BatchStats solveBatch(const vector<int> &sources, const BatchCallback &onResult, ThreadPool &pool, QueueKind kind);
+    void dijkstra(int src, const vector<int> &routeTargets = {});
+
+private:
+    // scratch state of boundedSearch, kept all-unreached between calls
+    vector<int> localDist;
+    vector<char> localDone;
+    vector<int> localTouched;
+
+    void buildReverse();
+
+    template <class Queue>
+    void solveBatchWith(const vector<int> &sources, const BatchCallback &onResult, ThreadPool &pool,
+                        const Queue &prototype, BatchStats &stats);
+};
+
+// Packs the adjacency lists into the contiguous CSR arrays. Call once after
+// loading; dijkstra() freezes on its own if the graph is still mutable.
+void DijkstraGraph::freeze()
+{
+    if (frozen)
+    {
+        return;
+    }
+
+    offsets.assign(V + 1, 0);
+    for (int u = 0; u < V; ++u)
+    {
+        offsets[u + 1] = offsets[u] + (int)adjList[u].size();
+    }
+
+    edgeDest.resize(offsets[V]);
+    edgeWeight.resize(offsets[V]);
+    for (int u = 0; u < V; ++u)
+    {
+        int k = offsets[u];
+        for (const DijEdge &edge : adjList[u])
+        {
+            edgeDest[k] = edge.dest;
+            edgeWeight[k] = edge.weight;
+            ++k;
+        }
+    }
+
+    vector<vector<DijEdge>>().swap(adjList);
+    buildReverse();
+}
+
+// Fills the weight range and the reverse CSR from the forward arrays.
+void DijkstraGraph::buildReverse()
+{
+    minWeight = offsets[V] > 0 ? INT_MAX : 0;
+    maxWeight = 0;
+    for (int weight : edgeWeight)
+    {
+        minWeight = min(minWeight, weight);
+        maxWeight = max(maxWeight, weight);
+    }
+
+    // reverse adjacency for backward searches, by counting sort on the destination
+    revOffsets.assign(V + 1, 0);
+    for (int k = 0; k < offsets[V]; ++k)
+    {
+        ++revOffsets[edgeDest[k] + 1];
+    }
+    for (int v = 0; v < V; ++v)
+    {
+        revOffsets[v + 1] += revOffsets[v];
+    }
+    revSrc.resize(offsets[V]);
+    revWeight.resize(offsets[V]);
+    vector<int> next(revOffsets.begin(), revOffsets.end() - 1);
+    for (int u = 0; u < V; ++u)
+    {
+        for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+        {
+            int slot = next[edgeDest[k]]++;
+            revSrc[slot] = u;
+            revWeight[slot] = edgeWeight[k];
+        }
+    }
+
+    frozen = true;
+}
+
+// Builds the frozen form straight from a flat edge list (anything with
+// src/dest/weight members), skipping the per-vertex builder vectors. Edges
+// keep their input order within each vertex, as freeze() would.
+template <class EdgeList>
+void DijkstraGraph::freezeFrom(const EdgeList &edges)
+{
+    vector<vector<DijEdge>>().swap(adjList);
+    ++version;
+    cache.clear();
+
+    offsets.assign(V + 1, 0);
+    for (const auto &edge : edges)
+    {
+        ++offsets[edge.src + 1];
+    }
+    for (int u = 0; u < V; ++u)
+    {
+        offsets[u + 1] += offsets[u];
+    }
+    edgeDest.resize(offsets[V]);
+    edgeWeight.resize(offsets[V]);
+    vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (const auto &edge : edges)
+    {
+        int slot = next[edge.src]++;
+        edgeDest[slot] = edge.dest;
+        edgeWeight[slot] = edge.weight;
+    }
+
+    buildReverse();
+}
+
+// Rebuilds the adjacency lists from the CSR arrays so addEdge can be used again.
+void DijkstraGraph::thaw()
+{
+    adjList.assign(V, vector<DijEdge>());
+    for (int u = 0; u < V; ++u)
+    {
+        adjList[u].reserve(offsets[u + 1] - offsets[u]);
+        for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+        {
+            adjList[u].push_back({edgeDest[k], edgeWeight[k]});
+        }
+    }
+
+    offsets.clear();
+    edgeDest.clear();
+    edgeWeight.clear();
+    revOffsets.clear();
+    revSrc.clear();
+    revWeight.clear();
+    mapping.reset();
+    frozen = false;
+}
+
+// Single-source Dijkstra over the CSR arrays with any queue from above. With
+// reverse set it follows the reverse arrays, giving distances to src. With
+// TrackParents, tree receives the parent of every reached vertex; it is a
+// template parameter so distance-only runs have no extra branch per relaxation.
+template <bool TrackParents, class Queue>
+void DijkstraGraph::run(int src, vector<int> &dist, Queue &pq, bool reverse, PredecessorTree *tree)
+{
+    freeze();
+
+    dist.assign(V, INT_MAX);
+    dist[src] = 0;
+    int *parent = nullptr;
+    if (TrackParents)
+    {
+        tree->src = src;
+        tree->parent.assign(V, -1);
+        parent = tree->parent.data();
+    }
+
+    const int *rowStart = reverse ? revOffsets.data() : offsets.data();
+    const int *dest = reverse ? revSrc.data() : edgeDest.data();
+    const int *weights = reverse ? revWeight.data() : edgeWeight.data();
+
+    pq.reset(V);
+    pq.push(src, 0);
+
+    while (!pq.empty())
+    {
+        int du;
+        int u = pq.pop(du);
+        if (du > dist[u])
+        {
+            SSSP_COUNT(pq.stats.stalePops, 1);
+            continue;
+        }
+
+        SSSP_COUNT(pq.stats.edgesScanned, rowStart[u + 1] - rowStart[u]);
+        for (int k = rowStart[u]; k < rowStart[u + 1]; ++k)
+        {
+            int v = dest[k];
+            int weight = weights[k];
+
+            if (du + weight < dist[v])
+            {
+                dist[v] = du + weight;
+                SSSP_COUNT(pq.stats.relaxations, 1);
+                if (TrackParents)
+                {
+                    parent[v] = u;
+                }
+                pq.push(v, dist[v]);
+            }
+        }
+    }
+}
+
+// Maps Auto to a concrete queue from the weight range seen by freeze(). The
+// monotone integer queues need non-negative weights, so a forced Dial or radix
+// request on a graph with negative weights falls back to the 4-ary heap, and
+// Dial falls back to the radix heap when it would need too many buckets.
+QueueKind DijkstraGraph::resolveQueue(QueueKind kind) const
+{
+    bool monotone = minWeight >= 0;
+    if (kind == QueueKind::Auto)
+    {
+        if (!monotone)
+            return QueueKind::FourAry;
+        return maxWeight <= DIAL_MAX_WEIGHT ? QueueKind::Dial : QueueKind::Radix;
+    }
+    if ((kind == QueueKind::Dial || kind == QueueKind::Radix) && !monotone)
+    {
+        return QueueKind::FourAry;
+    }
+    if (kind == QueueKind::Dial && maxWeight > DIAL_LIMIT_WEIGHT)
+    {
+        return QueueKind::Radix;
+    }
+    return kind;
+}
+
+QueueStats DijkstraGraph::shortestPaths(int src, QueueKind kind, vector<int> &dist, bool reverse, PredecessorTree *tree)
+{
+    freeze();
+
+    auto solve = [&](auto &pq)
+    {
+        if (tree)
+        {
+            run<true>(src, dist, pq, reverse, tree);
+        }
+        else
+        {
+            run(src, dist, pq, reverse);
+        }
+        return pq.stats;
+    };
+
+    switch (resolveQueue(kind))
+    {
+    case QueueKind::Lazy:
+    {
+        LazyHeap pq;
+        return solve(pq);
+    }
+    case QueueKind::Pairing:
+    {
+        PairingHeap pq;
+        return solve(pq);
+    }
+    case QueueKind::Dial:
+    {
+        DialBuckets pq(maxWeight);
+        return solve(pq);
+    }
+    case QueueKind::Radix:
+    {
+        RadixHeap pq;
+        return solve(pq);
+    }
+    case QueueKind::FourAry:
+    default:
+    {
+        FourAryHeap pq;
+        return solve(pq);
+    }
+    }
+}
+
+// Early-stopping Dijkstra for local questions: stop once limit.target is
+// settled, after limit.k vertices besides src, or before the first vertex
+// farther than limit.radius (whichever comes first). settled receives the
+// vertices in order of distance. Scratch distances persist between calls
+// and only the touched entries are reset, and the lazy heap starts empty,
+// so after the first call the cost follows the explored region, not V.
+// Needs non-negative weights; returns false otherwise.
+bool DijkstraGraph::boundedSearch(int src, const SearchLimit &limit, vector<SettledVertex> &settled,
+                                  QueueStats &stats)
+{
+    freeze();
+    settled.clear();
+    if (minWeight < 0)
+    {
+        return false;
+    }
+    if (localDist.size() != (size_t)V)
+    {
+        localDist.assign(V, INT_MAX);
+        localDone.assign(V, 0);
+    }
+
+    LazyHeap pq;
+    pq.reset(V);
+    localTouched.push_back(src);
+    localDist[src] = 0;
+    pq.push(src, 0);
+
+    while (!pq.empty())
+    {
+        int du;
+        int u = pq.pop(du);
+        if (localDone[u])
+        {
+            SSSP_COUNT(pq.stats.stalePops, 1);
+            continue;
+        }
+        if (du > limit.radius)
+        {
+            break;
+        }
+        localDone[u] = 1;
+        if (u != src)
+        {
+            settled.push_back({u, du});
+        }
+        if (u == limit.target || settled.size() >= (size_t)limit.k)
+        {
+            break;
+        }
+
+        SSSP_COUNT(pq.stats.edgesScanned, offsets[u + 1] - offsets[u]);
+        for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+        {
+            int v = edgeDest[k];
+            int candidate = du + edgeWeight[k];
+            if (candidate < localDist[v] && candidate <= limit.radius)
+            {
+                if (localDist[v] == INT_MAX)
+                {
+                    localTouched.push_back(v);
+                }
+                localDist[v] = candidate;
+                SSSP_COUNT(pq.stats.relaxations, 1);
+                pq.push(v, candidate);
+            }
+        }
+    }
+
+    for (int v : localTouched)
+    {
+        localDist[v] = INT_MAX;
+        localDone[v] = 0;
+    }
+    localTouched.clear();
+    stats = pq.stats;
+    return true;
+}
+
+void printQueueStats(const QueueStats &stats)
+{
+    cout << "Queue pushes: " << stats.pushes << ", pops: " << stats.pops
+         << ", stale pops: " << stats.stalePops << ", edges scanned: " << stats.edgesScanned
+         << ", relaxations: " << stats.relaxations << endl;
+}
+
+// Prints "Route to user 7 (12): 0 -> 3 -> 7" per target from one tree.
+void printRoutes(const PredecessorTree &tree, const vector<int> &dist, const vector<int> &targets,
+                 const string &noun, const string &unit)
+{
+    vector<int> vertices, offsets;
+    tree.paths(targets, vertices, offsets);
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        if (offsets[i] == offsets[i + 1])
+        {
+            cout << "No route to " << noun << " " << targets[i] << endl;
+            continue;
+        }
+        cout << "Route to " << noun << " " << targets[i] << " (" << dist[targets[i]] << unit << "):";
+        for (int k = offsets[i]; k < offsets[i + 1]; ++k)
+        {
+            cout << (k == offsets[i] ? " " : " -> ") << vertices[k];
+        }
+        cout << endl;
+    }
+}
+
+// Solves from src and prints every distance, then the routes to routeTargets;
+// parents are only tracked when there are targets.
+void DijkstraGraph::dijkstra(int src, const vector<int> &routeTargets)
+{
+    auto start = high_resolution_clock::now();
+    if (!frozen)
+    {
+        freeze();
+        phases.build = microsSince(start);
+    }
+
+    vector<int> dist;
+
+    start = high_resolution_clock::now(); // Start measuring time
+
+    QueueStats stats;
+    PredecessorTree tree;
+    bool routes = !routeTargets.empty();
+    bool cached = !routes && cache.lookup(version, src, SsspAlgorithm::Dijkstra, dist);
+    if (!cached)
+    {
+        stats = shortestPaths(src, selectedQueue, dist, false, routes ? &tree : nullptr);
+        cache.store(version, src, SsspAlgorithm::Dijkstra, dist);
+    }
+
+    phases.solve = microsSince(start);
+    start = high_resolution_clock::now();
+
+    if (cached)
+    {
+        cout << "Served from the result cache in " << phases.solve << " microseconds" << endl;
+    }
+    else
+    {
+        cout << "Time taken by Dijkstra's algorithm: " << phases.solve << " microseconds" << endl;
+        cout << "Priority queue: " << queueName(resolveQueue(selectedQueue));
+        if (selectedQueue == QueueKind::Auto)
+        {
+            cout << " (auto)";
+        }
+        cout << endl;
+        printQueueStats(stats);
+    }
+
+    renderResult(src, dist, "Shortest distances from user " + to_string(src) + " to all other users:", "user", "");
+    if (routes)
+    {
+        printRoutes(tree, dist, routeTargets, "user", "");
+    }
+
+    phases.output = microsSince(start);
+    ostringstream fields;
+    fields << ", \"vertices\": " << V << ", \"edges\": " << edgeDest.size() << ", \"pushes\": " << stats.pushes
+           << ", \"pops\": " << stats.pops << ", \"stale_pops\": " << stats.stalePops
+           << ", \"edges_scanned\": " << stats.edgesScanned << ", \"relaxations\": " << stats.relaxations
+           << ", \"cache_hit\": " << (cached ? "true" : "false");
+    logQueryStats("dijkstra", queueName(resolveQueue(selectedQueue)), src, fields.str(), phases);
+}
+
+// Bucket width for delta-stepping: roughly the max weight over the average
+// degree, so one light phase relaxes about one edge per vertex.
+int DijkstraGraph::defaultDelta() const
+{
+    int avgDegree = V > 0 ? max(1, (int)(edgeDest.size() / V)) : 1;
+    return max(1, maxWeight / avgDegree);
+}
+
+// Parallel delta-stepping (Meyer & Sanders). Vertices sit in buckets of width
+// delta by tentative distance. The smallest bucket is settled by repeatedly
+// relaxing its light edges (weight <= delta) in parallel, then the heavy edges
+// of everything it settled are relaxed once. dist is updated with atomic
+// fetch-min, and each worker collects the vertices it improved in its own
+// list, which are merged into the buckets between phases. The final distances
+// are the same as dijkstra()'s; graphs with negative weights fall back to the
+// sequential engine.
+void DijkstraGraph::deltaStepping(int src, vector<int> &dist, ThreadPool &pool, int delta)
+{
+    freeze();
+
+    if (minWeight < 0)
+    {
+        shortestPaths(src, QueueKind::FourAry, dist);
+        return;
+    }
+    if (delta <= 0)
+    {
+        delta = defaultDelta();
+    }
+
+    vector<atomic<int>> tentative(V);
+    pool.parallelFor(V, 4096, [&](int begin, int end, int)
+                     {
+        for (int v = begin; v < end; ++v)
+        {
+            tentative[v].store(INT_MAX, memory_order_relaxed);
+        } });
+    tentative[src].store(0, memory_order_relaxed);
+
+    const int *rowStart = offsets.data();
+    const int *dest = edgeDest.data();
+    const int *weights = edgeWeight.data();
+
+    vector<vector<int>> buckets(1, vector<int>(1, src));
+    vector<vector<int>> improved(pool.size());
+    vector<int> frontier, settled;
+    vector<int> frontierStamp(V, -1);
+    vector<char> isSettled(V, 0);
+    int phase = 0;
+
+    // moves every vertex a worker improved into the bucket of its new distance
+    auto mergeImproved = [&]()
+    {
+        for (vector<int> &list : improved)
+        {
+            for (int v : list)
+            {
+                size_t b = (size_t)(tentative[v].load(memory_order_relaxed) / delta);
+                if (b >= buckets.size())
+                {
+                    buckets.resize(b + 1);
+                }
+                buckets[b].push_back(v);
+            }
+            list.clear();
+        }
+    };
+
+    // relaxes the edges of vertices[] whose weight is light (<= delta) or heavy
+    auto relaxEdges = [&](const vector<int> &vertices, bool light)
+    {
+        pool.parallelFor((int)vertices.size(), 256, [&](int begin, int end, int worker)
+                         {
+            vector<int> &out = improved[worker];
+            for (int i = begin; i < end; ++i)
+            {
+                int u = vertices[i];
+                int du = tentative[u].load(memory_order_relaxed);
+                for (int k = rowStart[u]; k < rowStart[u + 1]; ++k)
+                {
+                    int weight = weights[k];
+                    if ((weight <= delta) != light)
+                    {
+                        continue;
+                    }
+                    if (atomicFetchMin(tentative[dest[k]], du + weight))
+                    {
+                        out.push_back(dest[k]);
+                    }
+                }
+            } });
+    };
+
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        settled.clear();
+        while (!buckets[i].empty())
+        {
+            // keep the entries whose distance still falls in bucket i, once each
+            frontier.clear();
+            for (int v : buckets[i])
+            {
+                if (tentative[v].load(memory_order_relaxed) / delta == (int)i && frontierStamp[v] != phase)
+                {
+                    frontierStamp[v] = phase;
+                    frontier.push_back(v);
+                    if (!isSettled[v])
+                    {
+                        isSettled[v] = 1;
+                        settled.push_back(v);
+                    }
+                }
+            }
+            buckets[i].clear();
+            ++phase;
+
+            relaxEdges(frontier, true);
+            mergeImproved();
+        }
+
+        relaxEdges(settled, false);
+        mergeImproved();
+    }
+
+    dist.resize(V);
+    for (int v = 0; v < V; ++v)
+    {
+        dist[v] = tentative[v].load(memory_order_relaxed);
+    }
+}
+
+// Bidirectional Dijkstra: a forward search from src over the CSR arrays and a
+// backward search from dst over the reverse arrays, settling one vertex each
+// in turn. mu is the best src-dst path seen where the searches touch; once
+// the two queue minimums add up to at least mu no shorter path can exist.
+// Returns INT_MAX if dst is unreachable. Needs non-negative weights, so it
+// falls back to a one-to-all run otherwise.
+int DijkstraGraph::query(int src, int dst, PointQueryStats &stats)
+{
+    freeze();
+    stats = PointQueryStats();
+
+    if (minWeight < 0)
+    {
+        vector<int> dist;
+        QueueStats full = shortestPaths(src, QueueKind::FourAry, dist);
+        stats.forwardSettled = full.pops - full.stalePops;
+        return dist[dst];
+    }
+    if (src == dst)
+    {
+        return 0;
+    }
+
+    vector<int> distF(V, INT_MAX), distB(V, INT_MAX);
+    FourAryHeap forwardQueue, backwardQueue;
+    forwardQueue.reset(V);
+    backwardQueue.reset(V);
+    distF[src] = 0;
+    distB[dst] = 0;
+    forwardQueue.push(src, 0);
+    backwardQueue.push(dst, 0);
+
+    long long mu = LLONG_MAX;
+    bool forward = true;
+
+    // settles the top of one queue and relaxes its edges in that direction
+    auto step = [&](FourAryHeap &pq, vector<int> &mine, const vector<int> &other,
+                    const IntArray &rowStart, const IntArray &adj, const IntArray &weights)
+    {
+        int du;
+        int u = pq.pop(du);
+        stats.edgesScanned += rowStart[u + 1] - rowStart[u];
+        for (int k = rowStart[u]; k < rowStart[u + 1]; ++k)
+        {
+            int v = adj[k];
+            int dv = du + weights[k];
+            if (dv < mine[v])
+            {
+                mine[v] = dv;
+                pq.push(v, dv);
+            }
+            if (other[v] != INT_MAX)
+            {
+                mu = min(mu, (long long)dv + other[v]);
+            }
+        }
+    };
+
+    while (!forwardQueue.empty() && !backwardQueue.empty())
+    {
+        if ((long long)forwardQueue.topKey() + backwardQueue.topKey() >= mu)
+        {
+            break;
+        }
+        if (forward)
+        {
+            step(forwardQueue, distF, distB, offsets, edgeDest, edgeWeight);
+            ++stats.forwardSettled;
+        }
+        else
+        {
+            step(backwardQueue, distB, distF, revOffsets, revSrc, revWeight);
+            ++stats.backwardSettled;
+        }
+        forward = !forward;
+    }
+
+    return mu == LLONG_MAX ? INT_MAX : (int)mu;
+}
+
+// Runs one-to-all Dijkstra from every source on the pool. The graph is only
+// read, each worker owns its distance buffer and queue and reuses them for
+// every source it takes, and sources are balanced by work stealing.
+template <class Queue>
+void DijkstraGraph::solveBatchWith(const vector<int> &sources, const BatchCallback &onResult, ThreadPool &pool,
+                                   const Queue &prototype, BatchStats &stats)
+{
+    WorkStealingQueues tasks(pool.size());
+    tasks.distribute((int)sources.size());
+    mutex resultLock;
+
+    pool.runOnAll([&](int worker)
+                  {
+        Queue pq = prototype;
+        vector<int> dist;
+        int task;
+        while (tasks.pop(worker, task))
+        {
+            run(sources[task], dist, pq);
+            lock_guard<mutex> lock(resultLock);
+            onResult(sources[task], dist);
+        } });
+
+    stats.queries = (long long)sources.size();
+    stats.steals = tasks.stealCount();
+}
+
+BatchStats DijkstraGraph::solveBatch(const vector<int> &sources, const BatchCallback &onResult, ThreadPool &pool, QueueKind kind)
+{
+    freeze();
+    BatchStats stats;
+    auto start = high_resolution_clock::now();
+
+    switch (resolveQueue(kind))
+    {
+    case QueueKind::Lazy:
+        solveBatchWith(sources, onResult, pool, LazyHeap(), stats);
+        break;
+    case QueueKind::Pairing:
+        solveBatchWith(sources, onResult, pool, PairingHeap(), stats);
+        break;
+    case QueueKind::Dial:
+        solveBatchWith(sources, onResult, pool, DialBuckets(maxWeight), stats);
+        break;
+    case QueueKind::Radix:
+        solveBatchWith(sources, onResult, pool, RadixHeap(), stats);
+        break;
+    case QueueKind::FourAry:
+    default:
+        solveBatchWith(sources, onResult, pool, FourAryHeap(), stats);
+        break;
+    }
+
+    auto stop = high_resolution_clock::now();
+    stats.micros = duration_cast<microseconds>(stop - start).count();
+    return stats;
+}
+
+// Solves from every vertex at 1, 2, 4, ... threads up to --threads and
+// reports queries per second.
+void benchmarkBatch(DijkstraGraph &g)
+{
+    vector<int> sources(g.V);
+    for (int v = 0; v < g.V; ++v)
+    {
+        sources[v] = v;
+    }
+
+    vector<int> threadCounts;
+    for (int t = 1; t < workerThreads; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(workerThreads);
+
+    double baseline = 0;
+    for (int threads : threadCounts)
+    {
+        ThreadPool pool(threads);
+        long long reachable = 0;
+        BatchStats stats = g.solveBatch(sources, [&reachable](int, const vector<int> &dist)
+                                        { reachable += count_if(dist.begin(), dist.end(), [](int d)
+                                                                { return d != INT_MAX; }); },
+                                        pool, selectedQueue);
+
+        double qps = stats.queries * 1e6 / max(1LL, stats.micros);
+        if (baseline == 0)
+        {
+            baseline = qps;
+        }
+        cout << threads << " threads: " << stats.queries << " sources in " << stats.micros << " microseconds, "
+             << qps << " queries/s (x" << qps / baseline << "), " << stats.steals << " steals, "
+             << reachable << " reachable pairs" << endl;
+    }
+}
+
+// ALT: A* search with landmarks and the triangle inequality
+//
+// For a landmark L, d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L),
+// so the largest of these over all landmarks is a lower bound on the distance
+// left from v to t. A* with that bound as potential settles mostly vertices
+// that lie towards t. Every landmark costs one table of V ints for d(L, v)
+// and, unless forwardOnly is set, one more for d(v, L): 8 bytes per vertex per
+// landmark, or 4 with forward tables only. Needs non-negative weights.
+enum class LandmarkSelection
+{
+    Farthest,
+    Avoid
+};
+
+struct LandmarkOptions
+{
+    int count = 8;
+    LandmarkSelection selection = LandmarkSelection::Avoid;
+    bool forwardOnly = false;
+    unsigned seed = 1;
+};
+
+// landmark settings for the ALT queries, set with --landmarks=, --landmark-select= and --landmark-forward-only
+LandmarkOptions landmarkOptions;
+
+class LandmarkIndex
+{
+public:
+    vector<int> landmarks;
+    // vertex-major tables so the bound for one vertex reads one cache line:
+    // fromLandmark[v * k + i] = d(landmarks[i], v), toLandmark[v * k + i] = d(v, landmarks[i])
+    IntArray fromLandmark;
+    IntArray toLandmark;
+    // snapshot the tables borrow from, if they were loaded from one
+    shared_ptr<MappedFile> mapping;
+
+    bool build(DijkstraGraph &g, const LandmarkOptions &options);
+    void useTables(const vector<int> &ids, int vertices, const int *from, const int *to, shared_ptr<MappedFile> file);
+    int query(DijkstraGraph &g, int src, int dst, PointQueryStats &stats);
+    size_t memoryBytes() const;
+
+private:
+    int k = 0;
+    int V = 0;
+    int stride = 0; // row length of the tables; the first k entries of each row are filled
+
+    // query buffers, reset through touched so a query costs nothing proportional to V
+    vector<int> dist, pi, touched;
+    FourAryHeap pq;
+
+    void addLandmark(DijkstraGraph &g, int landmark, bool forwardOnly);
+    int potential(int v, int t) const;
+    int selectFarthest(DijkstraGraph &g) const;
+    int selectAvoid(DijkstraGraph &g, unsigned &rng) const;
+};
+
+size_t LandmarkIndex::memoryBytes() const
+{
+    return (fromLandmark.size() + toLandmark.size()) * sizeof(int);
+}
+
+// Fills column k of the tables, which build() sized for all landmarks up front.
+void LandmarkIndex::addLandmark(DijkstraGraph &g, int landmark, bool forwardOnly)
+{
+    vector<int> column;
+    g.shortestPaths(landmark, QueueKind::Auto, column);
+    for (int v = 0; v < V; ++v)
+    {
+        fromLandmark[(size_t)v * stride + k] = column[v];
+    }
+    if (!forwardOnly)
+    {
+        g.shortestPaths(landmark, QueueKind::Auto, column, true);
+        for (int v = 0; v < V; ++v)
+        {
+            toLandmark[(size_t)v * stride + k] = column[v];
+        }
+    }
+    landmarks.push_back(landmark);
+    ++k;
+}
+
+// Lower bound on d(v, t); INT_MAX when the tables prove t unreachable from v.
+int LandmarkIndex::potential(int v, int t) const
+{
+    const int *fromV = &fromLandmark[(size_t)v * stride];
+    const int *fromT = &fromLandmark[(size_t)t * stride];
+    int bound = 0;
+    for (int i = 0; i < k; ++i)
+    {
+        if (fromV[i] != INT_MAX)
+        {
+            if (fromT[i] == INT_MAX)
+            {
+                return INT_MAX; // L reaches v but not t, so v cannot reach t
+            }
+            bound = max(bound, fromT[i] - fromV[i]);
+        }
+    }
+    if (!toLandmark.empty())
+    {
+        const int *toV = &toLandmark[(size_t)v * stride];
+        const int *toT = &toLandmark[(size_t)t * stride];
+        for (int i = 0; i < k; ++i)
+        {
+            if (toT[i] != INT_MAX)
+            {
+                if (toV[i] == INT_MAX)
+                {
+                    return INT_MAX; // t reaches L but v does not, so v cannot reach t
+                }
+                bound = max(bound, toV[i] - toT[i]);
+            }
+        }
+    }
+    return bound;
+}
+
+// The vertex whose closest landmark is farthest away; unreached vertices count
+// as infinitely far, so other components get a landmark first.
+int LandmarkIndex::selectFarthest(DijkstraGraph &g) const
+{
+    int best = 0;
+    long long bestDistance = -1;
+    for (int v = 0; v < V; ++v)
+    {
+        long long closest = LLONG_MAX;
+        for (int i = 0; i < k; ++i)
+        {
+            int d = fromLandmark[(size_t)v * stride + i];
+            closest = min(closest, d == INT_MAX ? (long long)INT_MAX + 1 : (long long)d);
+        }
+        if (closest > bestDistance)
+        {
+            bestDistance = closest;
+            best = v;
+        }
+    }
+    (void)g;
+    return best;
+}
+
+// Goldberg and Werneck's avoid heuristic: grow a shortest path tree from a
+// random root, weigh each vertex by how badly the current landmarks bound its
+// distance from the root, and sum the weights over subtrees, zeroing subtrees
+// that already contain a landmark. Walking down from the heaviest vertex along
+// the heaviest children ends in a leaf that covers the worst bounded region.
+int LandmarkIndex::selectAvoid(DijkstraGraph &g, unsigned &rng) const
+{
+    rng = rng * 1103515245u + 12345u;
+    int root = (int)((rng >> 8) % (unsigned)V);
+
+    vector<int> treeDist;
+    g.shortestPaths(root, QueueKind::Auto, treeDist);
+
+    // any in-edge that is tight is a valid tree parent
+    vector<int> parent(V, -1);
+    vector<vector<int>> children(V);
+    for (int v = 0; v < V; ++v)
+    {
+        if (v == root || treeDist[v] == INT_MAX)
+        {
+            continue;
+        }
+        for (int e = g.revOffsets[v]; e < g.revOffsets[v + 1]; ++e)
+        {
+            int u = g.revSrc[e];
+            if (treeDist[u] != INT_MAX && treeDist[u] + g.revWeight[e] == treeDist[v] && (treeDist[u] < treeDist[v] || u < v))
+            {
+                parent[v] = u;
+                children[u].push_back(v);
+                break;
+            }
+        }
+    }
+
+    vector<char> isLandmark(V, 0);
+    for (int landmark : landmarks)
+    {
+        isLandmark[landmark] = 1;
+    }
+
+    // post-order over the tree with an explicit stack
+    vector<long long> size(V, 0);
+    vector<char> covered(V, 0);
+    vector<pair<int, size_t>> stack(1, {root, 0});
+    while (!stack.empty())
+    {
+        int v = stack.back().first;
+        size_t &next = stack.back().second;
+        if (next < children[v].size())
+        {
+            stack.push_back({children[v][next++], 0});
+            continue;
+        }
+        stack.pop_back();
+
+        int bound = k > 0 ? potential(root, v) : 0;
+        long long weight = bound == INT_MAX ? 0 : treeDist[v] - bound;
+        covered[v] |= isLandmark[v];
+        size[v] += weight;
+        for (int c : children[v])
+        {
+            covered[v] |= covered[c];
+            size[v] += size[c];
+        }
+        if (covered[v])
+        {
+            size[v] = 0;
+        }
+    }
+
+    int heaviest = max_element(size.begin(), size.end()) - size.begin();
+    if (size[heaviest] == 0)
+    {
+        return selectFarthest(g);
+    }
+    int leaf = heaviest;
+    while (!children[leaf].empty())
+    {
+        int next = children[leaf][0];
+        for (int c : children[leaf])
+        {
+            if (size[c] > size[next])
+            {
+                next = c;
+            }
+        }
+        leaf = next;
+    }
+    return leaf;
+}
+
+bool LandmarkIndex::build(DijkstraGraph &g, const LandmarkOptions &options)
+{
+    g.freeze();
+    landmarks.clear();
+    fromLandmark.clear();
+    toLandmark.clear();
+    mapping.reset();
+    dist.clear();
+    touched.clear();
+    k = 0;
+    V = g.V;
+    stride = 0;
+    if (g.minWeight < 0 || V == 0)
+    {
+        return false;
+    }
+
+    unsigned rng = options.seed;
+    int count = max(0, min(options.count, V));
+    stride = count;
+    fromLandmark.assign((size_t)V * stride, INT_MAX);
+    if (!options.forwardOnly)
+    {
+        toLandmark.assign((size_t)V * stride, INT_MAX);
+    }
+
+    // farthest selection starts from the vertex farthest from a random one
+    if (options.selection == LandmarkSelection::Farthest && count > 0)
+    {
+        rng = rng * 1103515245u + 12345u;
+        int root = (int)((rng >> 8) % (unsigned)V);
+        vector<int> fromRandom;
+        g.shortestPaths(root, QueueKind::Auto, fromRandom);
+        int first = root;
+        for (int v = 0; v < V; ++v)
+        {
+            if (fromRandom[v] != INT_MAX && fromRandom[v] >= fromRandom[first])
+            {
+                first = v;
+            }
+        }
+        addLandmark(g, first, options.forwardOnly);
+    }
+
+    while (k < count)
+    {
+        int next = options.selection == LandmarkSelection::Avoid ? selectAvoid(g, rng) : selectFarthest(g);
+        if (find(landmarks.begin(), landmarks.end(), next) != landmarks.end())
+        {
+            break;
+        }
+        addLandmark(g, next, options.forwardOnly);
+    }
+
+    // selection ran out of new landmarks early: close up the unused columns once
+    if (k < stride)
+    {
+        auto shrink = [this](IntArray &table)
+        {
+            if (table.empty())
+            {
+                return;
+            }
+            for (int v = 1; v < V; ++v) // row 0 is already in place
+            {
+                copy(table.begin() + (size_t)v * stride, table.begin() + (size_t)v * stride + k, table.begin() + (size_t)v * k);
+            }
+            table.resize((size_t)V * k);
+        };
+        shrink(fromLandmark);
+        shrink(toLandmark);
+        stride = k;
+    }
+    return true;
+}
+
+// Takes tables computed earlier (from a snapshot) instead of building them.
+// to may be null for forward-only tables.
+void LandmarkIndex::useTables(const vector<int> &ids, int vertices, const int *from, const int *to, shared_ptr<MappedFile> file)
+{
+    landmarks = ids;
+    k = (int)ids.size();
+    V = vertices;
+    stride = k;
+    fromLandmark.borrow(from, (size_t)V * k);
+    if (to != nullptr)
+    {
+        toLandmark.borrow(to, (size_t)V * k);
+    }
+    else
+    {
+        toLandmark.clear();
+    }
+    mapping = move(file);
+    dist.clear();
+    touched.clear();
+}
+
+// A* from src to dst with the landmark bound as potential. The potential is
+// consistent, so a vertex is final when settled and the search stops at dst.
+int LandmarkIndex::query(DijkstraGraph &g, int src, int dst, PointQueryStats &stats)
+{
+    stats = PointQueryStats();
+    if (k == 0 || g.V != V)
+    {
+        return g.query(src, dst, stats);
+    }
+
+    if ((int)dist.size() != V)
+    {
+        dist.assign(V, INT_MAX);
+        pi.assign(V, -1);
+        pq.reset(V);
+    }
+    for (int v : touched)
+    {
+        dist[v] = INT_MAX;
+        pi[v] = -1;
+    }
+    touched.clear();
+    pq.clear();
+
+    touched.push_back(src);
+    pi[src] = potential(src, dst);
+    if (pi[src] == INT_MAX)
+    {
+        return INT_MAX;
+    }
+    dist[src] = 0;
+    pq.push(src, pi[src]);
+
+    while (!pq.empty())
+    {
+        int key;
+        int u = pq.pop(key);
+        ++stats.forwardSettled;
+        if (u == dst)
+        {
+            return dist[u];
+        }
+
+        stats.edgesScanned += g.offsets[u + 1] - g.offsets[u];
+        for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e)
+        {
+            int v = g.edgeDest[e];
+            int dv = dist[u] + g.edgeWeight[e];
+            if (dv >= dist[v])
+            {
+                continue;
+            }
+            if (pi[v] < 0)
+            {
+                touched.push_back(v);
+                pi[v] = potential(v, dst);
+            }
+            if (pi[v] == INT_MAX)
+            {
+                continue;
+            }
+            dist[v] = dv;
+            pq.push(v, dv + pi[v]);
+        }
+    }
+    return INT_MAX;
+}
+
+// Times the sequential engine against delta-stepping at 1, 2, 4, ... threads
+// up to --threads and checks that every run returns the same distances.
+void benchmarkDeltaStepping(DijkstraGraph &g, int src)
+{
+    const int repetitions = 3;
+
+    vector<int> reference;
+    long long sequential = LLONG_MAX;
+    for (int r = 0; r < repetitions; ++r)
+    {
+        auto start = high_resolution_clock::now();
+        g.shortestPaths(src, selectedQueue, reference);
+        auto stop = high_resolution_clock::now();
+        sequential = min(sequential, (long long)duration_cast<microseconds>(stop - start).count());
+    }
+    cout << "Sequential Dijkstra (" << queueName(g.resolveQueue(selectedQueue)) << "): "
+         << sequential << " microseconds" << endl;
+    cout << "Delta-stepping with delta " << g.defaultDelta() << ":" << endl;
+
+    vector<int> threadCounts;
+    for (int t = 1; t < workerThreads; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(workerThreads);
+
+    for (int threads : threadCounts)
+    {
+        ThreadPool pool(threads);
+        vector<int> dist;
+        long long best = LLONG_MAX;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            auto start = high_resolution_clock::now();
+            g.deltaStepping(src, dist, pool);
+            auto stop = high_resolution_clock::now();
+            best = min(best, (long long)duration_cast<microseconds>(stop - start).count());
+        }
+
+        cout << threads << " threads: " << best << " microseconds, speedup "
+             << (double)sequential / max(1LL, best)
+             << (dist == reference ? "" : " (distances differ!)") << endl;
+    }
+}
+
+// bellman-ford
+struct bellEdges
+{
+    int src, dest, weight;
+};
+
+// How BellmanFordGraph::bellmanFord relaxes edges. Classic sweeps the whole
+// edge list each round, Frontier only the out-edges of vertices improved in
+// the previous round, Spfa keeps a worklist ordered with the SLF and LLL
+// heuristics, Parallel splits each sweep across the thread pool, and Simd
+// sweeps the structure-of-arrays copy with a vectorized kernel. All of them
+// stop as soon as nothing changes.
+enum class BellmanMode
+{
+    Classic,
+    Frontier,
+    Spfa,
+    Parallel,
+    Simd
+};
+
+const BellmanMode allBellmanModes[] = {BellmanMode::Classic, BellmanMode::Frontier, BellmanMode::Spfa, BellmanMode::Parallel, BellmanMode::Simd};
+
+string bellmanModeName(BellmanMode mode)
+{
+    switch (mode)
+    {
+    case BellmanMode::Classic:
+        return "classic";
+    case BellmanMode::Frontier:
+        return "frontier";
+    case BellmanMode::Spfa:
+        return "spfa";
+    case BellmanMode::Parallel:
+        return "parallel";
+    case BellmanMode::Simd:
+        return "simd";
+    }
+    return "unknown";
+}
+
+bool parseBellmanMode(const string &name, BellmanMode &mode)
+{
+    for (BellmanMode candidate : allBellmanModes)
+    {
+        if (bellmanModeName(candidate) == name)
+        {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// work done by one Bellman-Ford run; rounds stay 0 for the SPFA worklist
+struct BellmanStats
+{
+    long long rounds = 0;
+    long long vertexPops = 0;
+    long long edgesScanned = 0;
+    long long improvements = 0;
+};
+
+// relaxation mode used by BellmanFordGraph::bellmanFord, set from the GPS menu or --bf=
+BellmanMode selectedBellmanMode = BellmanMode::Frontier;
+
+// Relaxation kernels for the structure-of-arrays edge store. One call is one
+// sweep over edges [0, E) that lowers dist in place and returns how many
+// updates it made. The vector kernels gather dist[src] and dist[dst] for a
+// block of edges, add the weights and compare in registers; only lanes that
+// improve fall back to a scalar min per destination, which also resolves
+// lanes sharing a destination (they are adjacent since edges are sorted by
+// destination). Within a block, edges read dist[src] as it was before the
+// block, so a sweep may need one more round than the scalar kernel, but the
+// converged distances are identical.
+enum class RelaxKernel
+{
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+string relaxKernelName(RelaxKernel kernel)
+{
+    switch (kernel)
+    {
+    case RelaxKernel::Scalar:
+        return "scalar";
+    case RelaxKernel::Avx2:
+        return "avx2";
+    case RelaxKernel::Avx512:
+        return "avx512";
+    }
+    return "unknown";
+}
+
+long long relaxSweepScalar(const int *src, const int *dst, const int *w, int E, int *dist)
+{
+    long long improved = 0;
+    for (int j = 0; j < E; ++j)
+    {
+        int du = dist[src[j]];
+        if (du != INT_MAX && du + w[j] < dist[dst[j]])
+        {
+            dist[dst[j]] = du + w[j];
+            ++improved;
+        }
+    }
+    return improved;
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BELLMAN_X86_KERNELS 1
+
+__attribute__((target("avx2"))) long long relaxSweepAvx2(const int *src, const int *dst, const int *w, int E, int *dist)
+{
+    const __m256i unreachable = _mm256_set1_epi32(INT_MAX);
+    alignas(32) int candidates[8];
+    long long improved = 0;
+    int j = 0;
+    for (; j + 8 <= E; j += 8)
+    {
+        __m256i from = _mm256_loadu_si256((const __m256i *)(src + j));
+        __m256i to = _mm256_loadu_si256((const __m256i *)(dst + j));
+        __m256i du = _mm256_i32gather_epi32(dist, from, 4);
+        __m256i dv = _mm256_i32gather_epi32(dist, to, 4);
+        __m256i candidate = _mm256_add_epi32(du, _mm256_loadu_si256((const __m256i *)(w + j)));
+        __m256i better = _mm256_andnot_si256(_mm256_cmpeq_epi32(du, unreachable), _mm256_cmpgt_epi32(dv, candidate));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(better));
+        if (mask == 0)
+        {
+            continue;
+        }
+        _mm256_store_si256((__m256i *)candidates, candidate);
+        for (; mask; mask &= mask - 1)
+        {
+            int lane = __builtin_ctz(mask);
+            int v = dst[j + lane];
+            if (candidates[lane] < dist[v])
+            {
+                dist[v] = candidates[lane];
+                ++improved;
+            }
+        }
+    }
+    return improved + relaxSweepScalar(src + j, dst + j, w + j, E - j, dist);
+}
+
+__attribute__((target("avx512f"))) long long relaxSweepAvx512(const int *src, const int *dst, const int *w, int E, int *dist)
+{
+    const __m512i unreachable = _mm512_set1_epi32(INT_MAX);
+    alignas(64) int candidates[16];
+    long long improved = 0;
+    int j = 0;
+    for (; j + 16 <= E; j += 16)
+    {
+        __m512i from = _mm512_loadu_si512((const void *)(src + j));
+        __m512i to = _mm512_loadu_si512((const void *)(dst + j));
+        __m512i du = _mm512_mask_i32gather_epi32(unreachable, 0xFFFF, from, dist, 4);
+        __m512i dv = _mm512_mask_i32gather_epi32(unreachable, 0xFFFF, to, dist, 4);
+        __m512i candidate = _mm512_add_epi32(du, _mm512_loadu_si512((const void *)(w + j)));
+        __mmask16 reachable = _mm512_cmpneq_epi32_mask(du, unreachable);
+        unsigned mask = _mm512_mask_cmplt_epi32_mask(reachable, candidate, dv);
+        if (mask == 0)
+        {
+            continue;
+        }
+        _mm512_store_si512((void *)candidates, candidate);
+        for (; mask; mask &= mask - 1)
+        {
+            int lane = __builtin_ctz(mask);
+            int v = dst[j + lane];
+            if (candidates[lane] < dist[v])
+            {
+                dist[v] = candidates[lane];
+                ++improved;
+            }
+        }
+    }
+    return improved + relaxSweepScalar(src + j, dst + j, w + j, E - j, dist);
+}
+#endif
+
+bool relaxKernelSupported(RelaxKernel kernel)
+{
+    switch (kernel)
+    {
+    case RelaxKernel::Scalar:
+        return true;
+#ifdef BELLMAN_X86_KERNELS
+    case RelaxKernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case RelaxKernel::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+// widest kernel the CPU running the program supports
+RelaxKernel detectRelaxKernel()
+{
+    if (relaxKernelSupported(RelaxKernel::Avx512))
+        return RelaxKernel::Avx512;
+    if (relaxKernelSupported(RelaxKernel::Avx2))
+        return RelaxKernel::Avx2;
+    return RelaxKernel::Scalar;
+}
+
+using RelaxSweepFn = long long (*)(const int *, const int *, const int *, int, int *);
+
+RelaxSweepFn relaxSweepFor(RelaxKernel kernel)
+{
+#ifdef BELLMAN_X86_KERNELS
+    if (kernel == RelaxKernel::Avx512 && relaxKernelSupported(kernel))
+        return relaxSweepAvx512;
+    if (kernel == RelaxKernel::Avx2 && relaxKernelSupported(kernel))
+        return relaxSweepAvx2;
+#endif
+    (void)kernel;
+    return relaxSweepScalar;
+}
+
+// kernel used by the simd Bellman-Ford mode
+RelaxKernel selectedKernel = detectRelaxKernel();
+
+class BellmanFordGraph
+{
+public:
+    int V, E;
+    vector<bellEdges> edges;
+
+    // out-edges grouped by source for the worklist modes, rebuilt on demand
+    vector<int> outOffsets;
+    vector<int> outDest;
+    vector<int> outWeight;
+    bool outIndexed;
+
+    // structure-of-arrays copy sorted by destination for the simd mode
+    vector<int> soaSrc;
+    vector<int> soaDest;
+    vector<int> soaWeight;
+    bool soaBuilt;
+
+    PhaseTimes phases;
+
+    uint64_t version = 0;
+    SsspCache cache;
+
+    // workers of the parallel mode, started by its first solve and reused after
+    shared_ptr<ThreadPool> pool;
+
+    BellmanFordGraph(int V, int E)
+    {
+        this->V = V;
+        this->E = E;
+        edges.resize(E);
+        outIndexed = false;
+        soaBuilt = false;
+    }
+
+    void addEdge(int u, int v, int w, int i)
+    {
+        edges[i] = {u, v, w};
+        outIndexed = false;
+        soaBuilt = false;
+        ++version;
+        cache.clear();
+    }
+
+    void buildOutIndex();
+    void buildSoA();
+    void prepare(BellmanMode mode);
+    bool solve(int src, BellmanMode mode, vector<int> &dist, BellmanStats &stats);
+    bool solveSimd(vector<int> &dist, BellmanStats &stats, RelaxKernel kernel);
+    void predecessors(int src, const vector<int> &dist, PredecessorTree &tree);
+    void bellmanFord(int src, const vector<int> &routeTargets = {});
+
+private:
+    bool solveClassic(int src, vector<int> &dist, BellmanStats &stats);
+    bool solveFrontier(int src, vector<int> &dist, BellmanStats &stats);
+    bool solveSpfa(int src, vector<int> &dist, BellmanStats &stats);
+    bool solveParallel(int src, vector<int> &dist, BellmanStats &stats);
+};
+
+// Builds the index the given mode reads, so it is not timed as solving.
+void BellmanFordGraph::prepare(BellmanMode mode)
+{
+    if (mode == BellmanMode::Frontier || mode == BellmanMode::Spfa)
+    {
+        buildOutIndex();
+    }
+    else if (mode == BellmanMode::Simd)
+    {
+        buildSoA();
+    }
+}
+
+// Counting sort of the edge list by source into CSR arrays.
+void BellmanFordGraph::buildOutIndex()
+{
+    if (outIndexed)
+    {
+        return;
+    }
+
+    outOffsets.assign(V + 1, 0);
+    for (const bellEdges &edge : edges)
+    {
+        ++outOffsets[edge.src + 1];
+    }
+    for (int u = 0; u < V; ++u)
+    {
+        outOffsets[u + 1] += outOffsets[u];
+    }
+
+    outDest.resize(E);
+    outWeight.resize(E);
+    vector<int> next(outOffsets.begin(), outOffsets.end() - 1);
+    for (const bellEdges &edge : edges)
+    {
+        int k = next[edge.src]++;
+        outDest[k] = edge.dest;
+        outWeight[k] = edge.weight;
+    }
+    outIndexed = true;
+}
+
+// Counting sort of the edge list by destination into separate arrays.
+void BellmanFordGraph::buildSoA()
+{
+    if (soaBuilt)
+    {
+        return;
+    }
+
+    vector<int> start(V + 1, 0);
+    for (const bellEdges &edge : edges)
+    {
+        ++start[edge.dest + 1];
+    }
+    for (int v = 0; v < V; ++v)
+    {
+        start[v + 1] += start[v];
+    }
+
+    soaSrc.resize(E);
+    soaDest.resize(E);
+    soaWeight.resize(E);
+    for (const bellEdges &edge : edges)
+    {
+        int k = start[edge.dest]++;
+        soaSrc[k] = edge.src;
+        soaDest[k] = edge.dest;
+        soaWeight[k] = edge.weight;
+    }
+    soaBuilt = true;
+}
+
+// Fills dist from src and returns false if a negative cycle is reachable.
+bool BellmanFordGraph::solve(int src, BellmanMode mode, vector<int> &dist, BellmanStats &stats)
+{
+    stats = BellmanStats();
+    dist.assign(V, INT_MAX);
+    dist[src] = 0;
+
+    switch (mode)
+    {
+    case BellmanMode::Classic:
+        return solveClassic(src, dist, stats);
+    case BellmanMode::Spfa:
+        return solveSpfa(src, dist, stats);
+    case BellmanMode::Parallel:
+        return solveParallel(src, dist, stats);
+    case BellmanMode::Simd:
+        return solveSimd(dist, stats, selectedKernel);
+    case BellmanMode::Frontier:
+    default:
+        return solveFrontier(src, dist, stats);
+    }
+}
+
+bool BellmanFordGraph::solveClassic(int src, vector<int> &dist, BellmanStats &stats)
+{
+    (void)src;
+    bool changed = true;
+    for (int i = 1; i <= V - 1 && changed; ++i)
+    {
+        changed = false;
+        ++stats.rounds;
+        stats.edgesScanned += E;
+        for (int j = 0; j < E; ++j)
+        {
+            int u = edges[j].src;
+            int v = edges[j].dest;
+            int weight = edges[j].weight;
+            if (dist[u] != INT_MAX && dist[u] + weight < dist[v])
+            {
+                dist[v] = dist[u] + weight;
+                SSSP_COUNT(stats.improvements, 1);
+                changed = true;
+            }
+        }
+    }
+
+    // a round without changes proves convergence, otherwise check once more
+    if (!changed)
+    {
+        return true;
+    }
+    for (int j = 0; j < E; ++j)
+    {
+        int u = edges[j].src;
+        int v = edges[j].dest;
+        int weight = edges[j].weight;
+        if (dist[u] != INT_MAX && dist[u] + weight < dist[v])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Round-based worklist: round k relaxes the out-edges of the vertices whose
+// distance improved in round k - 1. Without a negative cycle every shortest
+// path has at most V - 1 edges, so an improvement in round V proves a cycle.
+bool BellmanFordGraph::solveFrontier(int src, vector<int> &dist, BellmanStats &stats)
+{
+    buildOutIndex();
+
+    vector<int> frontier(1, src), next;
+    vector<char> inNext(V, 0);
+
+    while (!frontier.empty())
+    {
+        ++stats.rounds;
+        for (int u : frontier)
+        {
+            int du = dist[u];
+            SSSP_COUNT(stats.edgesScanned, outOffsets[u + 1] - outOffsets[u]);
+            for (int k = outOffsets[u]; k < outOffsets[u + 1]; ++k)
+            {
+                int v = outDest[k];
+                if (du + outWeight[k] < dist[v])
+                {
+                    dist[v] = du + outWeight[k];
+                    SSSP_COUNT(stats.improvements, 1);
+                    if (!inNext[v])
+                    {
+                        inNext[v] = 1;
+                        next.push_back(v);
+                    }
+                }
+            }
+        }
+
+        if (stats.rounds >= V && !next.empty())
+        {
+            return false;
+        }
+        for (int v : next)
+        {
+            inNext[v] = 0;
+        }
+        frontier.swap(next);
+        next.clear();
+    }
+    return true;
+}
+
+// SPFA with Small Label First (an improved vertex goes to the front if it
+// beats the current front) and Large Label Last (fronts above the queue
+// average are rotated to the back). pathLength[v] counts the edges behind
+// dist[v]; reaching V edges means the walk repeats a vertex with a lower
+// distance, i.e. it went around a negative cycle.
+bool BellmanFordGraph::solveSpfa(int src, vector<int> &dist, BellmanStats &stats)
+{
+    buildOutIndex();
+
+    deque<int> worklist(1, src);
+    vector<char> queued(V, 0);
+    vector<int> pathLength(V, 0);
+    queued[src] = 1;
+    long long queuedSum = 0;
+
+    while (!worklist.empty())
+    {
+        // LLL: bounded by the queue length so equal labels cannot spin forever
+        size_t rotations = worklist.size();
+        while (rotations-- > 1 && (long long)dist[worklist.front()] * (long long)worklist.size() > queuedSum)
+        {
+            worklist.push_back(worklist.front());
+            worklist.pop_front();
+        }
+
+        int u = worklist.front();
+        worklist.pop_front();
+        queued[u] = 0;
+        queuedSum -= dist[u];
+        SSSP_COUNT(stats.vertexPops, 1);
+
+        int du = dist[u];
+        SSSP_COUNT(stats.edgesScanned, outOffsets[u + 1] - outOffsets[u]);
+        for (int k = outOffsets[u]; k < outOffsets[u + 1]; ++k)
+        {
+            int v = outDest[k];
+            int candidate = du + outWeight[k];
+            if (candidate >= dist[v])
+            {
+                continue;
+            }
+            SSSP_COUNT(stats.improvements, 1);
+            pathLength[v] = pathLength[u] + 1;
+            if (pathLength[v] >= V)
+            {
+                return false;
+            }
+
+            if (queued[v])
+            {
+                queuedSum -= dist[v] - candidate;
+                dist[v] = candidate;
+                continue;
+            }
+            dist[v] = candidate;
+            queued[v] = 1;
+            queuedSum += candidate;
+            if (!worklist.empty() && candidate < dist[worklist.front()])
+            {
+                worklist.push_front(v);
+            }
+            else
+            {
+                worklist.push_back(v);
+            }
+        }
+    }
+    return true;
+}
+
+// Classic sweeps with the edge list cut into one contiguous slice per worker.
+// Updates go through atomic fetch-min, so a worker may already see values
+// another worker lowered in the same sweep; that only speeds convergence and
+// the converged distances are the same as the sequential modes'. The negative
+// cycle check after V - 1 changing sweeps runs in parallel as well.
+bool BellmanFordGraph::solveParallel(int src, vector<int> &dist, BellmanStats &stats)
+{
+    (void)src;
+    int threads = min(workerThreads, max(1, E / 4096));
+    if (threads > 1 && (!pool || pool->size() != threads))
+    {
+        pool = make_shared<ThreadPool>(threads);
+    }
+    auto runOnAll = [&](const function<void(int)> &task)
+    {
+        if (threads == 1)
+            task(0);
+        else
+            pool->runOnAll(task);
+    };
+
+    vector<atomic<int>> shared(V);
+    for (int v = 0; v < V; ++v)
+    {
+        shared[v].store(dist[v], memory_order_relaxed);
+    }
+
+    vector<long long> improvements(threads, 0);
+    atomic<bool> changed(true);
+    auto sweep = [&](int worker)
+    {
+        int begin = (int)((long long)E * worker / threads);
+        int end = (int)((long long)E * (worker + 1) / threads);
+        long long local = 0;
+        for (int j = begin; j < end; ++j)
+        {
+            int du = shared[edges[j].src].load(memory_order_relaxed);
+            if (du != INT_MAX && atomicFetchMin(shared[edges[j].dest], du + edges[j].weight))
+            {
+                ++local;
+            }
+        }
+        improvements[worker] += local;
+        if (local > 0)
+        {
+            changed.store(true, memory_order_relaxed);
+        }
+    };
+
+    for (int i = 1; i <= V - 1 && changed.load(); ++i)
+    {
+        changed.store(false);
+        ++stats.rounds;
+        stats.edgesScanned += E;
+        runOnAll(sweep);
+    }
+
+    bool cycle = false;
+    if (changed.load())
+    {
+        atomic<bool> relaxable(false);
+        runOnAll([&](int worker)
+                 {
+            int begin = (int)((long long)E * worker / threads);
+            int end = (int)((long long)E * (worker + 1) / threads);
+            for (int j = begin; j < end && !relaxable.load(memory_order_relaxed); ++j)
+            {
+                int du = shared[edges[j].src].load(memory_order_relaxed);
+                if (du != INT_MAX && du + edges[j].weight < shared[edges[j].dest].load(memory_order_relaxed))
+                {
+                    relaxable.store(true, memory_order_relaxed);
+                }
+            } });
+        cycle = relaxable.load();
+    }
+
+    for (int v = 0; v < V; ++v)
+    {
+        dist[v] = shared[v].load(memory_order_relaxed);
+    }
+    for (long long count : improvements)
+    {
+        stats.improvements += count;
+    }
+    return !cycle;
+}
+
+// Classic sweeps over the structure-of-arrays copy with the given kernel.
+bool BellmanFordGraph::solveSimd(vector<int> &dist, BellmanStats &stats, RelaxKernel kernel)
+{
+    buildSoA();
+    RelaxSweepFn sweep = relaxSweepFor(kernel);
+
+    long long improved = 1;
+    for (int i = 1; i <= V - 1 && improved > 0; ++i)
+    {
+        ++stats.rounds;
+        stats.edgesScanned += E;
+        improved = sweep(soaSrc.data(), soaDest.data(), soaWeight.data(), E, dist.data());
+        stats.improvements += improved;
+    }
+
+    // the check sweep may lower dist further, but only when it reports a cycle
+    return improved == 0 || sweep(soaSrc.data(), soaDest.data(), soaWeight.data(), E, dist.data()) == 0;
+}
+
+// Parents from the final distances: a breadth-first walk from src over tight
+// roads (dist[u] + w == dist[v]). Taking the first tight road into each vertex
+// could close a loop of zero weight roads; the walk cannot.
+void BellmanFordGraph::predecessors(int src, const vector<int> &dist, PredecessorTree &tree)
+{
+    buildOutIndex();
+    tree.src = src;
+    tree.parent.assign(V, -1);
+
+    vector<int> order(1, src);
+    vector<char> seen(V, 0);
+    seen[src] = 1;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int u = order[i];
+        for (int k = outOffsets[u]; k < outOffsets[u + 1]; ++k)
+        {
+            int v = outDest[k];
+            if (!seen[v] && dist[u] + outWeight[k] == dist[v])
+            {
+                seen[v] = 1;
+                tree.parent[v] = u;
+                order.push_back(v);
+            }
+        }
+    }
+}
+
+// Solves from src and prints every distance, then the routes to routeTargets;
+// parents are only worked out when there are targets.
+void BellmanFordGraph::bellmanFord(int src, const vector<int> &routeTargets)
+{
+    vector<int> dist;
+    BellmanStats stats;
+
+    auto start = high_resolution_clock::now();
+    bool cached = cache.lookup(version, src, SsspAlgorithm::BellmanFord, dist);
+    if (!cached)
+    {
+        prepare(selectedBellmanMode);
+        phases.build = microsSince(start);
+        start = high_resolution_clock::now(); // Start measuring time
+    }
+
+    bool ok = cached || solve(src, selectedBellmanMode, dist, stats);
+    if (ok && !cached)
+    {
+        cache.store(version, src, SsspAlgorithm::BellmanFord, dist);
+    }
+
+    phases.solve = microsSince(start);
+    start = high_resolution_clock::now();
+
+    string variant = bellmanModeName(selectedBellmanMode);
+    if (selectedBellmanMode == BellmanMode::Simd)
+    {
+        variant += " " + relaxKernelName(selectedKernel);
+    }
+    ostringstream fields;
+    fields << ", \"vertices\": " << V << ", \"edges\": " << E << ", \"negative_cycle\": " << (ok ? "false" : "true")
+           << ", \"passes\": " << stats.rounds << ", \"vertex_pops\": " << stats.vertexPops
+           << ", \"edges_scanned\": " << stats.edgesScanned << ", \"relaxations\": " << stats.improvements
+           << ", \"cache_hit\": " << (cached ? "true" : "false");
+
+    if (!ok)
+    {
+        cout << "Graph contains negative weight cycle" << endl;
+        phases.output = microsSince(start);
+        logQueryStats("bellman-ford", variant, src, fields.str(), phases);
+        return;
+    }
+
+    if (cached)
+    {
+        cout << "Served from the result cache in " << phases.solve << " microseconds" << endl;
+    }
+    else
+    {
+        cout << "Time taken by Bellman-Ford algorithm: " << phases.solve << " microseconds" << endl;
+        cout << "Relaxation mode: " << bellmanModeName(selectedBellmanMode);
+        if (selectedBellmanMode == BellmanMode::Simd)
+        {
+            cout << " (" << relaxKernelName(selectedKernel) << ")";
+        }
+        cout << ", rounds: " << stats.rounds
+             << ", vertex pops: " << stats.vertexPops << ", edges scanned: " << stats.edgesScanned
+             << ", improvements: " << stats.improvements << endl;
+    }
+
+    renderResult(src, dist, "Shortest distances from location " + to_string(src) + ":", "location", " units");
+    if (!routeTargets.empty())
+    {
+        PredecessorTree tree;
+        predecessors(src, dist, tree);
+        printRoutes(tree, dist, routeTargets, "location", " units");
+    }
+
+    phases.output = microsSince(start);
+    logQueryStats("bellman-ford", variant, src, fields.str(), phases);
+}
+
+// contraction hierarchies
+//
+// Preprocessing contracts the vertices of a road graph one at a time in order
+// of edge difference (shortcuts added minus edges removed, plus the number of
+// already contracted neighbours to spread the order evenly). Contracting v adds
+// a shortcut u -> x for every path u -> v -> x that has no equally short
+// witness path avoiding v. A query then runs Dijkstra upward in rank from both
+// ends and takes the best meeting vertex, which touches only a few hundred
+// vertices even on large maps. Needs non-negative weights.
+
+// 64-bit FNV-1a, used to fingerprint graphs and checksum files
+uint64_t fnv1a(const void *data, size_t bytes, uint64_t hash = 14695981039346656037ULL)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct ChArc
+{
+    int to, weight, via; // via is the contracted middle vertex of a shortcut, -1 for a road
+};
+
+class ContractionHierarchy
+{
+public:
+    int V = 0;
+    vector<int> rank;
+    long long shortcuts = 0;
+    uint64_t fingerprint = 0; // of the graph the index was built from
+
+    // upward edges for the forward search: u -> upHead[k] with a higher rank
+    vector<int> upOffsets, upHead, upWeight, upVia;
+    // upward edges for the backward search: downTail[k] -> v with a higher rank tail
+    vector<int> downOffsets, downTail, downWeight, downVia;
+
+    static uint64_t graphFingerprint(const BellmanFordGraph &g);
+
+    bool build(const BellmanFordGraph &g);
+    int query(int src, int dst, PointQueryStats &stats);
+    bool save(const string &filename) const;
+    bool load(const string &filename);
+
+private:
+    // preprocessing state, released once build() finishes
+    vector<vector<ChArc>> outArcs, inArcs;
+    vector<char> contracted;
+    vector<int> deletedNeighbors;
+    vector<int> witnessDist, witnessTouched;
+
+    // query state, reset sparsely so a query costs nothing proportional to V
+    vector<int> distF, distB, touched;
+    FourAryHeap forwardQueue, backwardQueue;
+
+    void addArc(int u, int x, int weight, int via);
+    bool validCsr(const vector<int> &offsets, const vector<int> &ends, const vector<int> &weights,
+                  const vector<int> &via) const;
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> witnessQueue;
+
+    void witnessSearch(int u, int skip, int limit, int settleLimit);
+    int contractNode(int v, bool simulate);
+    int priority(int v);
+    void prepareQuery();
+};
+
+// Witness searches give up after this many settled vertices; a missed witness
+// only costs an unnecessary shortcut, never a wrong answer. Estimating the
+// priority of a vertex uses a tighter limit than actually contracting it.
+const int WITNESS_SETTLE_LIMIT = 500;
+const int WITNESS_SIMULATE_LIMIT = 50;
+
+uint64_t ContractionHierarchy::graphFingerprint(const BellmanFordGraph &g)
+{
+    uint64_t hash = fnv1a(&g.V, sizeof(g.V));
+    hash = fnv1a(&g.E, sizeof(g.E), hash);
+    return fnv1a(g.edges.data(), g.edges.size() * sizeof(bellEdges), hash);
+}
+
+// Adds u -> x or lowers an existing parallel arc.
+void ContractionHierarchy::addArc(int u, int x, int weight, int via)
+{
+    for (ChArc &arc : outArcs[u])
+    {
+        if (arc.to == x)
+        {
+            if (weight < arc.weight)
+            {
+                arc.weight = weight;
+                arc.via = via;
+                for (ChArc &back : inArcs[x])
+                {
+                    if (back.to == u)
+                    {
+                        back.weight = weight;
+                        back.via = via;
+                    }
+                }
+            }
+            return;
+        }
+    }
+    outArcs[u].push_back({x, weight, via});
+    inArcs[x].push_back({u, weight, via});
+}
+
+// Dijkstra from u over the remaining graph without skip, up to distance limit.
+void ContractionHierarchy::witnessSearch(int u, int skip, int limit, int settleLimit)
+{
+    for (int x : witnessTouched)
+    {
+        witnessDist[x] = INT_MAX;
+    }
+    witnessTouched.clear();
+
+    auto &pq = witnessQueue;
+    while (!pq.empty())
+    {
+        pq.pop();
+    }
+    witnessDist[u] = 0;
+    witnessTouched.push_back(u);
+    pq.push({0, u});
+
+    int settled = 0;
+    while (!pq.empty())
+    {
+        int d = pq.top().first;
+        int x = pq.top().second;
+        pq.pop();
+        if (d > witnessDist[x])
+        {
+            continue;
+        }
+        if (d > limit || ++settled > settleLimit)
+        {
+            break;
+        }
+        for (const ChArc &arc : outArcs[x])
+        {
+            int y = arc.to;
+            if (y == skip)
+            {
+                continue;
+            }
+            if (d + arc.weight < witnessDist[y])
+            {
+                if (witnessDist[y] == INT_MAX)
+                {
+                    witnessTouched.push_back(y);
+                }
+                witnessDist[y] = d + arc.weight;
+                pq.push({witnessDist[y], y});
+            }
+        }
+    }
+}
+
+// Returns how many shortcuts contracting v needs; adds them unless simulating.
+int ContractionHierarchy::contractNode(int v, bool simulate)
+{
+    vector<ChArc> needed;
+    vector<int> tails;
+    for (const ChArc &in : inArcs[v])
+    {
+        int u = in.to;
+        int limit = -1;
+        for (const ChArc &out : outArcs[v])
+        {
+            if (out.to != u)
+            {
+                limit = max(limit, in.weight + out.weight);
+            }
+        }
+        if (limit < 0)
+        {
+            continue;
+        }
+
+        witnessSearch(u, v, limit, simulate ? WITNESS_SIMULATE_LIMIT : WITNESS_SETTLE_LIMIT);
+        for (const ChArc &out : outArcs[v])
+        {
+            int x = out.to;
+            int through = in.weight + out.weight;
+            if (x != u && witnessDist[x] > through)
+            {
+                needed.push_back({x, through, v});
+                tails.push_back(u);
+            }
+        }
+    }
+
+    if (!simulate)
+    {
+        for (size_t i = 0; i < needed.size(); ++i)
+        {
+            addArc(tails[i], needed[i].to, needed[i].weight, v);
+        }
+    }
+    return (int)needed.size();
+}
+
+int ContractionHierarchy::priority(int v)
+{
+    int removed = (int)(inArcs[v].size() + outArcs[v].size());
+    return contractNode(v, true) - removed + deletedNeighbors[v];
+}
+
+bool ContractionHierarchy::build(const BellmanFordGraph &g)
+{
+    for (const bellEdges &edge : g.edges)
+    {
+        if (edge.weight < 0)
+        {
+            return false;
+        }
+    }
+
+    V = g.V;
+    fingerprint = graphFingerprint(g);
+    shortcuts = 0;
+    outArcs.assign(V, vector<ChArc>());
+    inArcs.assign(V, vector<ChArc>());
+    contracted.assign(V, 0);
+    deletedNeighbors.assign(V, 0);
+    witnessDist.assign(V, INT_MAX);
+    witnessTouched.clear();
+    rank.assign(V, -1);
+
+    for (const bellEdges &edge : g.edges)
+    {
+        if (edge.src != edge.dest)
+        {
+            addArc(edge.src, edge.dest, edge.weight, -1);
+        }
+    }
+
+    vector<vector<ChArc>> up(V), down(V);
+
+    // lazy updates: a popped vertex is re-evaluated and pushed back if its
+    // priority got worse than the next candidate's
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> order;
+    for (int v = 0; v < V; ++v)
+    {
+        order.push({priority(v), v});
+    }
+
+    int next = 0;
+    while (!order.empty())
+    {
+        int v = order.top().second;
+        order.pop();
+        if (contracted[v])
+        {
+            continue;
+        }
+        int current = priority(v);
+        if (!order.empty() && current > order.top().first)
+        {
+            order.push({current, v});
+            continue;
+        }
+
+        shortcuts += contractNode(v, false);
+        contracted[v] = 1;
+        rank[v] = next++;
+
+        // every arc still attached to v leads to a vertex contracted later
+        up[v] = outArcs[v];
+        down[v] = inArcs[v];
+        for (const ChArc &arc : outArcs[v])
+        {
+            vector<ChArc> &list = inArcs[arc.to];
+            list.erase(remove_if(list.begin(), list.end(), [v](const ChArc &a)
+                                 { return a.to == v; }),
+                       list.end());
+            ++deletedNeighbors[arc.to];
+        }
+        for (const ChArc &arc : inArcs[v])
+        {
+            vector<ChArc> &list = outArcs[arc.to];
+            list.erase(remove_if(list.begin(), list.end(), [v](const ChArc &a)
+                                 { return a.to == v; }),
+                       list.end());
+            ++deletedNeighbors[arc.to];
+        }
+        vector<ChArc>().swap(outArcs[v]);
+        vector<ChArc>().swap(inArcs[v]);
+    }
+
+    auto flatten = [this](const vector<vector<ChArc>> &lists, vector<int> &offsets, vector<int> &ends,
+                          vector<int> &weights, vector<int> &vias)
+    {
+        offsets.assign(V + 1, 0);
+        for (int v = 0; v < V; ++v)
+        {
+            offsets[v + 1] = offsets[v] + (int)lists[v].size();
+        }
+        ends.clear();
+        weights.clear();
+        vias.clear();
+        for (int v = 0; v < V; ++v)
+        {
+            for (const ChArc &arc : lists[v])
+            {
+                ends.push_back(arc.to);
+                weights.push_back(arc.weight);
+                vias.push_back(arc.via);
+            }
+        }
+    };
+    flatten(up, upOffsets, upHead, upWeight, upVia);
+    flatten(down, downOffsets, downTail, downWeight, downVia);
+
+    vector<vector<ChArc>>().swap(outArcs);
+    vector<vector<ChArc>>().swap(inArcs);
+    vector<char>().swap(contracted);
+    vector<int>().swap(deletedNeighbors);
+    vector<int>().swap(witnessDist);
+    vector<int>().swap(witnessTouched);
+    return true;
+}
+
+void ContractionHierarchy::prepareQuery()
+{
+    if ((int)distF.size() != V)
+    {
+        distF.assign(V, INT_MAX);
+        distB.assign(V, INT_MAX);
+        forwardQueue.reset(V);
+        backwardQueue.reset(V);
+    }
+    for (int v : touched)
+    {
+        distF[v] = distB[v] = INT_MAX;
+    }
+    touched.clear();
+    forwardQueue.clear();
+    backwardQueue.clear();
+}
+
+// Upward search from both ends. Each side keeps going while its smallest key
+// is below the best meeting distance; the answer is that distance.
+int ContractionHierarchy::query(int src, int dst, PointQueryStats &stats)
+{
+    stats = PointQueryStats();
+    prepareQuery();
+
+    distF[src] = 0;
+    distB[dst] = 0;
+    touched.push_back(src);
+    touched.push_back(dst);
+    forwardQueue.push(src, 0);
+    backwardQueue.push(dst, 0);
+
+    long long mu = src == dst ? 0 : LLONG_MAX;
+
+    auto step = [&](FourAryHeap &pq, vector<int> &mine, const vector<int> &other, const vector<int> &offsets,
+                    const vector<int> &ends, const vector<int> &weights)
+    {
+        int du;
+        int u = pq.pop(du);
+        if (other[u] != INT_MAX)
+        {
+            mu = min(mu, (long long)du + other[u]);
+        }
+        stats.edgesScanned += offsets[u + 1] - offsets[u];
+        for (int k = offsets[u]; k < offsets[u + 1]; ++k)
+        {
+            int x = ends[k];
+            int dx = du + weights[k];
+            if (dx < mine[x])
+            {
+                if (distF[x] == INT_MAX && distB[x] == INT_MAX)
+                {
+                    touched.push_back(x);
+                }
+                mine[x] = dx;
+                pq.push(x, dx);
+            }
+        }
+    };
+
+    bool forward = true;
+    while (true)
+    {
+        bool forwardLive = !forwardQueue.empty() && forwardQueue.topKey() < mu;
+        bool backwardLive = !backwardQueue.empty() && backwardQueue.topKey() < mu;
+        if (!forwardLive && !backwardLive)
+        {
+            break;
+        }
+        if ((forward && forwardLive) || !backwardLive)
+        {
+            step(forwardQueue, distF, distB, upOffsets, upHead, upWeight);
+            ++stats.forwardSettled;
+        }
+        else
+        {
+            step(backwardQueue, distB, distF, downOffsets, downTail, downWeight);
+            ++stats.backwardSettled;
+        }
+        forward = !forward;
+    }
+
+    return mu == LLONG_MAX ? INT_MAX : (int)mu;
+}
+
+// On-disk layout: "CHINDEX1", fingerprint, V and the two edge counts, then
+// rank and the upward and downward CSR arrays as raw 32-bit ints.
+bool ContractionHierarchy::save(const string &filename) const
+{
+    ofstream file(filename, ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    auto writeArray = [&file](const vector<int> &a)
+    {
+        file.write((const char *)a.data(), a.size() * sizeof(int));
+    };
+    int upCount = (int)upHead.size();
+    int downCount = (int)downTail.size();
+    file.write("CHINDEX1", 8);
+    file.write((const char *)&fingerprint, sizeof(fingerprint));
+    file.write((const char *)&V, sizeof(V));
+    file.write((const char *)&upCount, sizeof(upCount));
+    file.write((const char *)&downCount, sizeof(downCount));
+    writeArray(rank);
+    writeArray(upOffsets);
+    writeArray(upHead);
+    writeArray(upWeight);
+    writeArray(upVia);
+    writeArray(downOffsets);
+    writeArray(downTail);
+    writeArray(downWeight);
+    writeArray(downVia);
+    return (bool)file;
+}
+
+// A damaged index must not send query() out of bounds: offsets start at 0,
+// never decrease and end at the edge count, every endpoint and shortcut
+// middle is a vertex and no weight is negative.
+bool ContractionHierarchy::validCsr(const vector<int> &offsets, const vector<int> &ends, const vector<int> &weights,
+                                   const vector<int> &via) const
+{
+    if (offsets[0] != 0 || offsets[V] != (int)ends.size())
+    {
+        return false;
+    }
+    for (int u = 0; u < V; ++u)
+    {
+        if (offsets[u] > offsets[u + 1])
+        {
+            return false;
+        }
+    }
+    for (size_t k = 0; k < ends.size(); ++k)
+    {
+        if (ends[k] < 0 || ends[k] >= V || weights[k] < 0 || via[k] < -1 || via[k] >= V)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ContractionHierarchy::load(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    char magic[8];
+    int upCount, downCount;
+    file.read(magic, 8);
+    file.read((char *)&fingerprint, sizeof(fingerprint));
+    file.read((char *)&V, sizeof(V));
+    file.read((char *)&upCount, sizeof(upCount));
+    file.read((char *)&downCount, sizeof(downCount));
+    if (!file || string(magic, 8) != "CHINDEX1" || V < 0 || V == INT_MAX || upCount < 0 || downCount < 0)
+    {
+        V = 0;
+        return false;
+    }
+
+    // the counts must describe exactly the rest of the file before anything is allocated from them
+    streamoff headerEnd = file.tellg();
+    file.seekg(0, ios::end);
+    streamoff ints = (streamoff)V + 2 * ((streamoff)V + 1) + 3 * (streamoff)upCount + 3 * (streamoff)downCount;
+    if (file.tellg() != headerEnd + ints * (streamoff)sizeof(int))
+    {
+        V = 0;
+        return false;
+    }
+    file.seekg(headerEnd);
+
+    auto readArray = [&file](vector<int> &a, int n)
+    {
+        a.resize(n);
+        file.read((char *)a.data(), (streamsize)n * sizeof(int));
+    };
+    readArray(rank, V);
+    readArray(upOffsets, V + 1);
+    readArray(upHead, upCount);
+    readArray(upWeight, upCount);
+    readArray(upVia, upCount);
+    readArray(downOffsets, V + 1);
+    readArray(downTail, downCount);
+    readArray(downWeight, downCount);
+    readArray(downVia, downCount);
+    if (!file || !validCsr(upOffsets, upHead, upWeight, upVia) || !validCsr(downOffsets, downTail, downWeight, downVia))
+    {
+        V = 0;
+        return false;
+    }
+    for (int r : rank)
+    {
+        if (r < 0 || r >= V)
+        {
+            V = 0;
+            return false;
+        }
+    }
+
+    shortcuts = 0;
+    for (int via : upVia)
+    {
+        shortcuts += via >= 0;
+    }
+    for (int via : downVia)
+    {
+        shortcuts += via >= 0;
+    }
+    distF.clear();
+    touched.clear();
+    return true;
+}
+
+// all-pairs shortest paths
+//
+// Dense city sets use a cache-blocked Floyd-Warshall: the matrix is cut into
+// 64 x 64 tiles, each round k first closes the diagonal tile, then the tiles
+// in its row and column, then all the others in parallel, all with the same
+// min-plus tile kernel. Sparse graphs use Johnson's algorithm instead:
+// Bellman-Ford potentials from a virtual source make every weight
+// non-negative, and the reweighted graph is solved from every source with
+// the parallel batch Dijkstra.
+enum class ApspMethod
+{
+    Auto,
+    FloydWarshall,
+    Johnson
+};
+
+string apspMethodName(ApspMethod method)
+{
+    switch (method)
+    {
+    case ApspMethod::Auto:
+        return "auto";
+    case ApspMethod::FloydWarshall:
+        return "blocked Floyd-Warshall";
+    case ApspMethod::Johnson:
+        return "Johnson";
+    }
+    return "unknown";
+}
+
+// "no path", as in the single-source solvers. It never takes part in a sum:
+// the kernels skip it, and skip sums that leave the int range.
+const int APSP_INF = INT_MAX;
+
+// Row-major V x V distances; rows are padded to a multiple of the tile size.
+// Unreachable pairs hold APSP_INF, so at() returns INT_MAX for them.
+struct DistanceMatrix
+{
+    int V = 0;
+    int stride = 0;
+    vector<int> cells;
+
+    int at(int i, int j) const
+    {
+        return cells[(size_t)i * stride + j];
+    }
+};
+
+const int APSP_TILE = 64;
+
+// C[i][j] = min(C[i][j], A[i][k] + B[k][j]) over one tile, k outermost so the
+// diagonal and row/column tiles can alias their inputs. A term with an
+// APSP_INF operand, or whose sum overflows, is skipped.
+void minPlusTileScalar(int *C, const int *A, const int *B, int stride)
+{
+    for (int k = 0; k < APSP_TILE; ++k)
+    {
+        const int *bRow = B + (size_t)k * stride;
+        for (int i = 0; i < APSP_TILE; ++i)
+        {
+            int aik = A[(size_t)i * stride + k];
+            if (aik == APSP_INF)
+            {
+                continue;
+            }
+            int *cRow = C + (size_t)i * stride;
+            for (int j = 0; j < APSP_TILE; ++j)
+            {
+                int through;
+                bool skip = __builtin_add_overflow(aik, bRow[j], &through) || bRow[j] == APSP_INF;
+                cRow[j] = min(cRow[j], skip ? APSP_INF : through);
+            }
+        }
+    }
+}
+
+#ifdef BELLMAN_X86_KERNELS
+// Lanes whose B operand is APSP_INF or whose sum overflows (the sign of the
+// sum differs from both operands) are replaced by APSP_INF before the min.
+__attribute__((target("avx2"))) void minPlusTileAvx2(int *C, const int *A, const int *B, int stride)
+{
+    const __m256i inf = _mm256_set1_epi32(APSP_INF);
+    for (int k = 0; k < APSP_TILE; ++k)
+    {
+        const int *bRow = B + (size_t)k * stride;
+        for (int i = 0; i < APSP_TILE; ++i)
+        {
+            int a = A[(size_t)i * stride + k];
+            if (a == APSP_INF)
+            {
+                continue;
+            }
+            __m256i aik = _mm256_set1_epi32(a);
+            int *cRow = C + (size_t)i * stride;
+            for (int j = 0; j < APSP_TILE; j += 8)
+            {
+                __m256i b = _mm256_loadu_si256((const __m256i *)(bRow + j));
+                __m256i c = _mm256_loadu_si256((const __m256i *)(cRow + j));
+                __m256i sum = _mm256_add_epi32(aik, b);
+                __m256i overflow = _mm256_srai_epi32(
+                    _mm256_and_si256(_mm256_xor_si256(aik, sum), _mm256_xor_si256(b, sum)), 31);
+                __m256i skip = _mm256_or_si256(overflow, _mm256_cmpeq_epi32(b, inf));
+                _mm256_storeu_si256((__m256i *)(cRow + j), _mm256_min_epi32(c, _mm256_blendv_epi8(sum, inf, skip)));
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) void minPlusTileAvx512(int *C, const int *A, const int *B, int stride)
+{
+    const __m512i inf = _mm512_set1_epi32(APSP_INF);
+    const __m512i zero = _mm512_setzero_si512();
+    for (int k = 0; k < APSP_TILE; ++k)
+    {
+        const int *bRow = B + (size_t)k * stride;
+        for (int i = 0; i < APSP_TILE; ++i)
+        {
+            int a = A[(size_t)i * stride + k];
+            if (a == APSP_INF)
+            {
+                continue;
+            }
+            __m512i aik = _mm512_set1_epi32(a);
+            int *cRow = C + (size_t)i * stride;
+            for (int j = 0; j < APSP_TILE; j += 16)
+            {
+                __m512i b = _mm512_loadu_si512((const void *)(bRow + j));
+                __m512i c = _mm512_loadu_si512((const void *)(cRow + j));
+                __m512i sum = _mm512_add_epi32(aik, b);
+                __mmask16 keep = _mm512_cmpneq_epi32_mask(b, inf) &
+                                 _mm512_cmpge_epi32_mask(_mm512_and_si512(_mm512_xor_si512(aik, sum), _mm512_xor_si512(b, sum)), zero);
+                _mm512_storeu_si512((void *)(cRow + j), _mm512_mask_min_epi32(c, keep, c, sum));
+            }
+        }
+    }
+}
+#endif
+
+using MinPlusTileFn = void (*)(int *, const int *, const int *, int);
+
+MinPlusTileFn minPlusTileFor(RelaxKernel kernel)
+{
+#ifdef BELLMAN_X86_KERNELS
+    if (kernel == RelaxKernel::Avx512 && relaxKernelSupported(kernel))
+        return minPlusTileAvx512;
+    if (kernel == RelaxKernel::Avx2 && relaxKernelSupported(kernel))
+        return minPlusTileAvx2;
+#endif
+    (void)kernel;
+    return minPlusTileScalar;
+}
+
+// The graph must not have a negative cycle, otherwise the sums can run past
+// the int range; allPairsShortestPaths checks that first.
+void floydWarshallBlocked(const BellmanFordGraph &g, DistanceMatrix &m, ThreadPool &pool, RelaxKernel relax)
+{
+    int tiles = (g.V + APSP_TILE - 1) / APSP_TILE;
+    m.V = g.V;
+    m.stride = tiles * APSP_TILE;
+    m.cells.assign((size_t)m.stride * m.stride, APSP_INF);
+    for (int i = 0; i < g.V; ++i)
+    {
+        m.cells[(size_t)i * m.stride + i] = 0;
+    }
+    for (const bellEdges &edge : g.edges)
+    {
+        int &cell = m.cells[(size_t)edge.src * m.stride + edge.dest];
+        cell = min(cell, edge.weight);
+    }
+
+    MinPlusTileFn kernel = minPlusTileFor(relax);
+    int stride = m.stride;
+    int *d = m.cells.data();
+    auto tile = [d, stride](int ti, int tj)
+    {
+        return d + (size_t)ti * APSP_TILE * stride + (size_t)tj * APSP_TILE;
+    };
+
+    for (int kt = 0; kt < tiles; ++kt)
+    {
+        kernel(tile(kt, kt), tile(kt, kt), tile(kt, kt), stride);
+
+        // row kt and column kt only depend on the diagonal tile
+        pool.parallelFor(2 * tiles, 1, [&](int begin, int end, int)
+                         {
+            for (int t = begin; t < end; ++t)
+            {
+                int other = t % tiles;
+                if (other == kt)
+                {
+                    continue;
+                }
+                if (t < tiles)
+                {
+                    kernel(tile(kt, other), tile(kt, kt), tile(kt, other), stride);
+                }
+                else
+                {
+                    kernel(tile(other, kt), tile(other, kt), tile(kt, kt), stride);
+                }
+            } });
+
+        // every remaining tile reads one finished row tile and one column tile
+        pool.parallelFor(tiles * tiles, 1, [&](int begin, int end, int)
+                         {
+            for (int t = begin; t < end; ++t)
+            {
+                int ti = t / tiles;
+                int tj = t % tiles;
+                if (ti != kt && tj != kt)
+                {
+                    kernel(tile(ti, tj), tile(ti, kt), tile(kt, tj), stride);
+                }
+            } });
+    }
+}
+
+// Johnson's reweighting: h[v] is the distance from a virtual source with a 0
+// edge to every vertex, so w + h[u] - h[v] >= 0 on every edge. Returns false
+// if the graph has a negative cycle.
+bool apspPotentials(const BellmanFordGraph &g, vector<int> &h)
+{
+    BellmanFordGraph extended(g.V + 1, g.E + g.V);
+    for (int j = 0; j < g.E; ++j)
+    {
+        extended.addEdge(g.edges[j].src, g.edges[j].dest, g.edges[j].weight, j);
+    }
+    for (int v = 0; v < g.V; ++v)
+    {
+        extended.addEdge(g.V, v, 0, g.E + v);
+    }
+    BellmanStats stats;
+    return extended.solve(g.V, BellmanMode::Frontier, h, stats);
+}
+
+void johnson(const BellmanFordGraph &g, const vector<int> &h, DistanceMatrix &m, ThreadPool &pool)
+{
+    DijkstraGraph reweighted(g.V);
+    for (const bellEdges &edge : g.edges)
+    {
+        reweighted.addEdge(edge.src, edge.dest, edge.weight + h[edge.src] - h[edge.dest]);
+    }
+    reweighted.freeze();
+
+    m.V = g.V;
+    m.stride = g.V;
+    m.cells.assign((size_t)g.V * g.V, APSP_INF);
+
+    vector<int> sources(g.V);
+    for (int v = 0; v < g.V; ++v)
+    {
+        sources[v] = v;
+    }
+    reweighted.solveBatch(sources, [&](int u, const vector<int> &dist)
+                          {
+        int *row = &m.cells[(size_t)u * m.stride];
+        for (int v = 0; v < g.V; ++v)
+        {
+            long long d = (long long)dist[v] - h[u] + h[v];
+            if (dist[v] != INT_MAX && d < APSP_INF && d >= INT_MIN)
+            {
+                row[v] = (int)d;
+            }
+        } },
+                          pool, QueueKind::Auto);
+}
+
+// Floyd-Warshall does V^3 work no matter how many edges there are, Johnson
+// about V * E * log V, so Floyd-Warshall wins once the average out-degree
+// reaches roughly V / 16 (and always for tiny graphs).
+ApspMethod chooseApspMethod(const BellmanFordGraph &g)
+{
+    if (g.V <= APSP_TILE || (long long)g.E * 16 >= (long long)g.V * g.V)
+    {
+        return ApspMethod::FloydWarshall;
+    }
+    return ApspMethod::Johnson;
+}
+
+// Returns false if the graph has a negative cycle.
+bool allPairsShortestPaths(const BellmanFordGraph &g, DistanceMatrix &m, ApspMethod &method)
+{
+    vector<int> h;
+    if (!apspPotentials(g, h))
+    {
+        return false;
+    }
+    if (method == ApspMethod::Auto)
+    {
+        method = chooseApspMethod(g);
+    }
+    ThreadPool pool(workerThreads);
+    if (method == ApspMethod::FloydWarshall)
+    {
+        floydWarshallBlocked(g, m, pool, selectedKernel);
+    }
+    else
+    {
+        johnson(g, h, m, pool);
+    }
+    return true;
+}
+
+// Asks for sources until the user enters -1, so one loaded graph answers
+// several queries and repeated sources come from its result cache.
+bool nextSource(const string &prompt, int V, int &src)
+{
+    while (true)
+    {
+        cout << prompt << " (-1 to go back): ";
+        if (!(cin >> src) || src < 0)
+        {
+            return false;
+        }
+        if (src < V)
+        {
+            return true;
+        }
+        cout << "Invalid choice, must be between 0 and " << V - 1 << "." << endl;
+    }
+}
+
+// Asks how many routes to show and reads that many destinations. Returns false
+// on an invalid destination, so the query is skipped.
+bool readRouteTargets(const string &noun, int V, vector<int> &targets)
+{
+    int count;
+    cout << "Show routes to how many " << noun << "s (0 for none): ";
+    cin >> count;
+    targets.clear();
+    for (int i = 0; i < count; ++i)
+    {
+        int target;
+        cout << "Destination " << i + 1 << ": ";
+        cin >> target;
+        if (target < 0 || target >= V)
+        {
+            cout << "Invalid destination." << endl;
+            return false;
+        }
+        targets.push_back(target);
+    }
+    return true;
+}
+
+// bellman-ford
+void inputMapManually(BellmanFordGraph &g)
+{
+    int V, E;
+    cout << "Enter the number of locations: ";
+    cin >> V;
+
+    if (V <= 0)
+    {
+        cout << "Number of locations must be a positive integer." << endl;
+        return;
+    }
+
+    cout << "Enter the number of roads: ";
+    cin >> E;
+
+    if (E < 0)
+    {
+        cout << "Number of roads must be a non-negative integer." << endl;
+        return;
+    }
+
+    g = BellmanFordGraph(V, E);
+
+    for (int i = 0; i < E; ++i)
+    {
+        int u, v, w;
+        cout << "Road " << i + 1 << " (start end distance): ";
+        cin >> u >> v >> w;
+
+        if (u < 0 || u >= V || v < 0 || v >= V)
+        {
+            cout << "Invalid road. Location indices must be between 0 and " << V - 1 << "." << endl;
+            return;
+        }
+
+        g.addEdge(u, v, w, i);
+    }
+
+    int src;
+    while (nextSource("Enter the starting location", V, src))
+    {
+        g.bellmanFord(src);
+    }
+}
+
+// memory-mapped edge lists
+//
+// The numeric map/graph files ("V E" then "u v w" per edge) are mapped with
+// MappedFile and cut into one chunk per worker at whitespace. Like the stream
+// reader they replace, any whitespace separates the numbers, so an edge may
+// span lines. A first pass counts the numbers in every chunk, which tells
+// each chunk which edge and field its first number belongs to; the second
+// pass parses with from_chars straight into the final edge array. There are
+// no per-edge allocations, no per-chunk copies of the edges and no
+// locale-aware stream in the loop.
+struct EdgeListFile
+{
+    int V = 0, E = 0;
+    vector<bellEdges> edges;
+    size_t bytes = 0;
+    long long micros = 0;
+};
+
+// What one worker found in its chunk of a whole-file parse. Token indices
+// count numbers from the first edge; -1 means nothing was found.
+struct TokenChunk
+{
+    size_t tokens = 0;
+    long long malformedToken = -1;
+    size_t errorOffset = 0;
+    long long badEdge = -1;
+};
+
+inline bool isSeparator(char c)
+{
+    return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+// High bit of each byte of word that is a separator. ASCII only: bytes with
+// the high bit set are never separators.
+inline uint64_t separatorBytes(uint64_t word)
+{
+    const uint64_t low7 = 0x7f7f7f7f7f7f7f7fULL;
+    const uint64_t high = 0x8080808080808080ULL;
+    uint64_t ascii = ~word & high;
+    uint64_t x = word & low7;
+    uint64_t spaces = ~((x ^ 0x2020202020202020ULL) + low7) & ascii;
+    uint64_t atLeastTab = x + 0x7777777777777777ULL;         // 0x80 - '\t' per byte
+    uint64_t pastCarriageReturn = x + 0x7272727272727272ULL; // 0x80 - ('\r' + 1) per byte
+    return (spaces | (atLeastTab & ~pastCarriageReturn)) & ascii;
+}
+
+// Counts token starts eight bytes at a time: a token starts at every
+// non-separator byte whose predecessor is a separator (or the start of p).
+size_t countTokens(const char *p, const char *end)
+{
+    size_t tokens = 0;
+    uint64_t previous = 1; // "byte -1" was a separator
+    for (; end - p >= 8; p += 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        uint64_t separators = separatorBytes(word) >> 7;
+        uint64_t starts = ~separators & ((separators << 8) | previous) & 0x0101010101010101ULL;
+        tokens += (starts * 0x0101010101010101ULL) >> 56;
+        previous = separators >> 56;
+    }
+    for (; p < end; ++p)
+    {
+        bool separator = isSeparator(*p);
+        tokens += previous && !separator;
+        previous = separator;
+    }
+    return tokens;
+}
+
+// Parses the numbers in [p, end), the first of which is number firstToken of
+// the edge list, into edges (sized for E edges). Stops at a malformed number
+// or once the E edges are complete.
+void parseEdgeTokens(const char *base, const char *p, const char *end, size_t firstToken, int V,
+                     vector<bellEdges> &edges, TokenChunk &chunk)
+{
+    size_t wanted = edges.size() * 3;
+    size_t e = firstToken / 3;
+    int field = (int)(firstToken % 3);
+    for (size_t t = firstToken; t < wanted; ++t)
+    {
+        while (p < end && isSeparator(*p))
+        {
+            ++p;
+        }
+        if (p == end)
+        {
+            return;
+        }
+
+        int value;
+        from_chars_result parsed = from_chars(p, end, value);
+        if (parsed.ec != errc() || (parsed.ptr < end && !isSeparator(*parsed.ptr)))
+        {
+            chunk.malformedToken = (long long)t;
+            chunk.errorOffset = p - base;
+            return;
+        }
+        p = parsed.ptr;
+
+        bellEdges &edge = edges[e];
+        if (field == 2)
+        {
+            edge.weight = value;
+            field = 0;
+            ++e;
+            continue;
+        }
+        (field == 0 ? edge.src : edge.dest) = value;
+        ++field;
+        if (chunk.badEdge < 0 && (unsigned)value >= (unsigned)V)
+        {
+            chunk.badEdge = (long long)e;
+        }
+    }
+}
+
+// Line-based parse for the streaming reader. Parsing stops at the first
+// malformed line; badRange is the chunk-local index of the first out-of-range
+// edge.
+struct EdgeChunk
+{
+    vector<bellEdges> edges;
+    bool malformed = false;
+    size_t errorOffset = 0;
+    long long badRange = -1;
+};
+
+inline const char *skipBlanks(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+        ++p;
+    }
+    return p;
+}
+
+void parseEdgeChunk(const char *base, const char *p, const char *end, int V, EdgeChunk &chunk)
+{
+    chunk.edges.reserve((end - p) / 8 + 1);
+    while (p < end)
+    {
+        p = skipBlanks(p, end);
+        if (p == end)
+        {
+            break;
+        }
+        if (*p == '\n')
+        {
+            ++p;
+            continue;
+        }
+
+        int field[3];
+        bool ok = true;
+        for (int f = 0; f < 3 && ok; ++f)
+        {
+            p = skipBlanks(p, end);
+            from_chars_result parsed = from_chars(p, end, field[f]);
+            ok = parsed.ec == errc();
+            p = parsed.ptr;
+        }
+        p = skipBlanks(p, end);
+        if (!ok || (p < end && *p != '\n'))
+        {
+            chunk.malformed = true;
+            chunk.errorOffset = p - base;
+            return;
+        }
+
+        if (chunk.badRange < 0 && (field[0] < 0 || field[0] >= V || field[1] < 0 || field[1] >= V))
+        {
+            chunk.badRange = (long long)chunk.edges.size();
+        }
+        chunk.edges.push_back({field[0], field[1], field[2]});
+    }
+}
+
+// Reads an edge list file into out. Like the stream reader it used to
+// replace, only the first E edges count and anything after them is ignored.
+bool readEdgeListFile(const string &filename, EdgeListFile &out)
+{
+    auto start = high_resolution_clock::now();
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        cerr << "Unable to open file " << filename << endl;
+        return false;
+    }
+    file.adviseSequential();
+    const char *begin = file.data;
+    const char *end = file.data + file.size;
+
+    // header: vertex count, then edge count
+    const char *p = begin;
+    int header[2] = {0, -1};
+    for (int f = 0; f < 2; ++f)
+    {
+        while (p < end && isspace((unsigned char)*p))
+        {
+            ++p;
+        }
+        from_chars_result parsed = from_chars(p, end, header[f]);
+        if (parsed.ec != errc())
+        {
+            cout << "Invalid header in " << filename << ": expected the vertex and edge counts." << endl;
+            return false;
+        }
+        p = parsed.ptr;
+    }
+    out.V = header[0];
+    out.E = header[1];
+    if (out.V <= 0 || out.E < 0)
+    {
+        cout << "Invalid number of vertices or edges in the file." << endl;
+        return false;
+    }
+
+    // one chunk per worker, at least a megabyte each, cut at whitespace
+    const size_t minChunk = 1 << 20;
+    int chunks = (int)max<size_t>(1, min<size_t>(workerThreads, (end - p) / minChunk));
+    vector<const char *> cut(chunks + 1, end);
+    cut[0] = p;
+    for (int c = 1; c < chunks; ++c)
+    {
+        const char *at = max(p + (end - p) / chunks * c, cut[c - 1]);
+        while (at < end && !isSeparator(*at))
+        {
+            ++at;
+        }
+        cut[c] = at;
+    }
+
+    vector<TokenChunk> parts(chunks);
+    ThreadPool pool(chunks);
+    pool.runOnAll([&](int c)
+                  { parts[c].tokens = countTokens(cut[c], cut[c + 1]); });
+
+    vector<size_t> firstToken(chunks + 1, 0);
+    for (int c = 0; c < chunks; ++c)
+    {
+        firstToken[c + 1] = firstToken[c] + parts[c].tokens;
+    }
+    if (firstToken.back() < (size_t)out.E * 3)
+    {
+        cout << filename << " ends after " << firstToken.back() / 3 << " of " << out.E << " edges." << endl;
+        return false;
+    }
+
+    out.edges.resize(out.E);
+    pool.runOnAll([&](int c)
+                  { parseEdgeTokens(begin, cut[c], cut[c + 1], firstToken[c], out.V, out.edges, parts[c]); });
+
+    // the first E edges in file order must be well formed and in range
+    for (int c = 0; c < chunks; ++c)
+    {
+        long long badToken = parts[c].badEdge >= 0 ? parts[c].badEdge * 3 : -1;
+        if (badToken >= 0 && (parts[c].malformedToken < 0 || badToken < parts[c].malformedToken))
+        {
+            cout << "Invalid edge in the file. Vertex indices must be between 0 and " << out.V - 1 << "." << endl;
+            return false;
+        }
+        if (parts[c].malformedToken >= 0)
+        {
+            cout << "Malformed edge at byte " << parts[c].errorOffset << " of " << filename << "." << endl;
+            return false;
+        }
+    }
+
+    out.bytes = file.size;
+    out.micros = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+    return true;
+}
+
+void printParseRate(const EdgeListFile &file)
+{
+    double megabytes = file.bytes / (1024.0 * 1024.0);
+    double seconds = max(file.micros, 1LL) / 1e6;
+    cout << "Parsed " << file.E << " edges (" << megabytes << " MB) in " << file.micros << " microseconds, "
+         << megabytes / seconds << " MB/s" << endl;
+}
+
+// graph snapshots
+//
+// A snapshot is the loaded form of a graph file, written once with the save
+// command and mapped on later starts instead of parsing the text again:
+//
+//   header   magic "GRAPHSNP", byte-order mark, format version, section count,
+//            vertex and edge counts, size and modification time of the text
+//            file it was made from, checksum
+//   table    one {tag, offset, bytes} entry per section
+//   sections 64-byte aligned arrays, each identified by its tag
+//
+// Frozen Dijkstra graphs store their forward and reverse CSR arrays and
+// optionally the ALT landmark tables; the arrays are used in place from the
+// mapping. City lists store the names and the road list. The checksum covers
+// the header, the table and every section, hashed in 64 MB blocks across the
+// workers, so a corrupted or truncated file is rejected before it is used.
+const char SNAPSHOT_MAGIC[8] = {'G', 'R', 'A', 'P', 'H', 'S', 'N', 'P'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+const size_t SNAPSHOT_ALIGN = 64;
+const size_t SNAPSHOT_HASH_BLOCK = (size_t)64 << 20;
+
+enum class SnapshotTag : uint32_t
+{
+    Offsets = 1,
+    EdgeDest,
+    EdgeWeight,
+    RevOffsets,
+    RevSrc,
+    RevWeight,
+    WeightRange,  // {minWeight, maxWeight}
+    Landmarks,    // landmark vertex ids
+    FromLandmark, // vertex-major, V * landmarks
+    ToLandmark,   // same, absent for forward-only tables
+    NameOffsets,  // V + 1 byte offsets into NameChars
+    NameChars,
+    Edges         // {src, dest, weight} triples in file order
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint32_t sections;
+    uint32_t reserved;
+    uint64_t vertices, edges;
+    uint64_t sourceBytes;
+    int64_t sourceModified;
+    uint64_t checksum;
+};
+
+struct SnapshotSection
+{
+    uint32_t tag;
+    uint32_t reserved;
+    uint64_t offset, bytes;
+};
+
+// Four-lane multiply-rotate hash over 8-byte words, fast enough that
+// checking a snapshot costs about as much as faulting its pages in.
+uint64_t snapshotHash(const char *data, size_t bytes)
+{
+    const uint64_t prime = 0x9e3779b97f4a7c15ull;
+    uint64_t lane[4] = {1, 2, 3, 4};
+    size_t words = bytes / 8;
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4)
+    {
+        for (int l = 0; l < 4; ++l)
+        {
+            uint64_t word;
+            memcpy(&word, data + (i + l) * 8, 8);
+            lane[l] = (lane[l] ^ word) * prime;
+            lane[l] = (lane[l] << 31) | (lane[l] >> 33);
+        }
+    }
+    uint64_t hash = bytes;
+    for (int l = 0; l < 4; ++l)
+    {
+        hash = (hash ^ lane[l]) * prime;
+    }
+    return fnv1a(data + i * 8, bytes - i * 8, hash);
+}
+
+// Hashes the header (with its checksum field zeroed), the table and the
+// sections, cutting sections into blocks so large arrays hash in parallel.
+uint64_t snapshotChecksum(const SnapshotHeader &header, const vector<SnapshotSection> &table,
+                          const vector<const char *> &sectionData)
+{
+    SnapshotHeader unstamped = header;
+    unstamped.checksum = 0;
+
+    vector<pair<const char *, size_t>> blocks;
+    blocks.push_back({(const char *)&unstamped, sizeof(unstamped)});
+    blocks.push_back({(const char *)table.data(), table.size() * sizeof(SnapshotSection)});
+    for (size_t s = 0; s < table.size(); ++s)
+    {
+        for (uint64_t at = 0; at < table[s].bytes; at += SNAPSHOT_HASH_BLOCK)
+        {
+            blocks.push_back({sectionData[s] + at, (size_t)min<uint64_t>(SNAPSHOT_HASH_BLOCK, table[s].bytes - at)});
+        }
+    }
+
+    vector<uint64_t> blockHash(blocks.size());
+    ThreadPool pool(min<int>(workerThreads, (int)blocks.size()));
+    pool.parallelFor((int)blocks.size(), 1, [&](int begin, int end, int)
+                     {
+        for (int b = begin; b < end; ++b)
+        {
+            blockHash[b] = snapshotHash(blocks[b].first, blocks[b].second);
+        } });
+    return fnv1a(blockHash.data(), blockHash.size() * sizeof(uint64_t));
+}
+
+// Size and modification time of the text file a snapshot was made from, so
+// a snapshot older than its source is not used. Zero when the file is missing.
+void sourceStamp(const string &filename, uint64_t &bytes, int64_t &modified)
+{
+    error_code error;
+    bytes = filesystem::file_size(filename, error);
+    if (error)
+    {
+        bytes = 0;
+        modified = 0;
+        return;
+    }
+    modified = (int64_t)filesystem::last_write_time(filename, error).time_since_epoch().count();
+}
+
+string snapshotPathFor(const string &source)
+{
+    size_t dot = source.find_last_of('.');
+    return (dot == string::npos ? source : source.substr(0, dot)) + ".snap";
+}
+
+class SnapshotWriter
+{
+public:
+    uint64_t vertices = 0, edges = 0;
+
+    void add(SnapshotTag tag, const void *data, size_t bytes)
+    {
+        pieces.push_back({tag, (const char *)data, bytes});
+    }
+
+    bool save(const string &filename, const string &source) const;
+
+private:
+    struct Piece
+    {
+        SnapshotTag tag;
+        const char *data;
+        size_t bytes;
+    };
+    vector<Piece> pieces;
+};
+
+bool SnapshotWriter::save(const string &filename, const string &source) const
+{
+    SnapshotHeader header = {};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.version = SNAPSHOT_VERSION;
+    header.sections = (uint32_t)pieces.size();
+    header.vertices = vertices;
+    header.edges = edges;
+    sourceStamp(source, header.sourceBytes, header.sourceModified);
+
+    auto align = [](uint64_t at)
+    {
+        return (at + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    };
+    vector<SnapshotSection> table(pieces.size());
+    vector<const char *> sectionData(pieces.size());
+    uint64_t at = align(sizeof(header) + table.size() * sizeof(SnapshotSection));
+    for (size_t s = 0; s < pieces.size(); ++s)
+    {
+        table[s] = {(uint32_t)pieces[s].tag, 0, at, pieces[s].bytes};
+        sectionData[s] = pieces[s].data;
+        at = align(at + pieces[s].bytes);
+    }
+    header.checksum = snapshotChecksum(header, table, sectionData);
+
+    ofstream file(filename, ios::binary);
+    if (!file)
+    {
+        cerr << "Unable to write " << filename << endl;
+        return false;
+    }
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)table.data(), table.size() * sizeof(SnapshotSection));
+    uint64_t written = sizeof(header) + table.size() * sizeof(SnapshotSection);
+    const char padding[SNAPSHOT_ALIGN] = {};
+    for (size_t s = 0; s < pieces.size(); ++s)
+    {
+        file.write(padding, table[s].offset - written);
+        file.write(pieces[s].data, pieces[s].bytes);
+        written = table[s].offset + pieces[s].bytes;
+    }
+    file.write(padding, align(written) - written);
+    return (bool)file;
+}
+
+class GraphSnapshot
+{
+public:
+    SnapshotHeader header = {};
+    shared_ptr<MappedFile> file;
+
+    // Maps filename and checks its header, layout and checksum. Returns
+    // false, after saying why, for anything but a missing file; a snapshot
+    // older than source is rejected too.
+    bool open(const string &filename, const string &source);
+
+    const char *section(SnapshotTag tag, size_t &bytes) const;
+    const int *ints(SnapshotTag tag, size_t &count) const;
+
+private:
+    vector<SnapshotSection> table;
+};
+
+bool GraphSnapshot::open(const string &filename, const string &source)
+{
+    error_code error;
+    if (!filesystem::exists(filename, error))
+    {
+        return false;
+    }
+    file = make_shared<MappedFile>();
+    if (!file->open(filename))
+    {
+        cerr << "Unable to open file " << filename << endl;
+        return false;
+    }
+
+    const char *data = file->data;
+    size_t size = file->size;
+    if (size < sizeof(header))
+    {
+        cout << filename << " is too short to be a snapshot." << endl;
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.byteOrder != SNAPSHOT_BYTE_ORDER)
+    {
+        cout << filename << " is not a snapshot written on this kind of machine." << endl;
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION)
+    {
+        cout << filename << " has snapshot format version " << header.version << ", this build reads version "
+             << SNAPSHOT_VERSION << ". Save it again." << endl;
+        return false;
+    }
+
+    uint64_t sourceBytes;
+    int64_t sourceModified;
+    sourceStamp(source, sourceBytes, sourceModified);
+    if (sourceBytes != 0 && (sourceBytes != header.sourceBytes || sourceModified != header.sourceModified))
+    {
+        cout << filename << " is older than " << source << ", reading the text file instead." << endl;
+        return false;
+    }
+
+    size_t tableEnd = sizeof(header) + (size_t)header.sections * sizeof(SnapshotSection);
+    if (header.sections > size / sizeof(SnapshotSection) || tableEnd > size)
+    {
+        cout << filename << " is truncated." << endl;
+        return false;
+    }
+    table.resize(header.sections);
+    memcpy(table.data(), data + sizeof(header), table.size() * sizeof(SnapshotSection));
+    vector<const char *> sectionData(table.size());
+    for (size_t s = 0; s < table.size(); ++s)
+    {
+        if (table[s].offset % SNAPSHOT_ALIGN != 0 || table[s].offset > size || table[s].bytes > size - table[s].offset)
+        {
+            cout << filename << " is truncated." << endl;
+            return false;
+        }
+        sectionData[s] = data + table[s].offset;
+    }
+
+    if (snapshotChecksum(header, table, sectionData) != header.checksum)
+    {
+        cout << filename << " is corrupted (checksum mismatch)." << endl;
+        return false;
+    }
+    return true;
+}
+
+// Null (bytes 0) when the snapshot has no such section.
+const char *GraphSnapshot::section(SnapshotTag tag, size_t &bytes) const
+{
+    for (const SnapshotSection &entry : table)
+    {
+        if (entry.tag == (uint32_t)tag)
+        {
+            bytes = (size_t)entry.bytes;
+            return file->data + entry.offset;
+        }
+    }
+    bytes = 0;
+    return nullptr;
+}
+
+const int *GraphSnapshot::ints(SnapshotTag tag, size_t &count) const
+{
+    size_t bytes;
+    const char *data = section(tag, bytes);
+    count = bytes / sizeof(int);
+    return (const int *)data;
+}
+
+// Writes the frozen graph, and the landmark tables if there are any.
+bool saveGraphSnapshot(const string &filename, const string &source, DijkstraGraph &g, const LandmarkIndex &alt)
+{
+    g.freeze();
+    int weightRange[2] = {g.minWeight, g.maxWeight};
+    int E = g.offsets[g.V];
+
+    SnapshotWriter writer;
+    writer.vertices = g.V;
+    writer.edges = E;
+    writer.add(SnapshotTag::Offsets, g.offsets.data(), g.offsets.size() * sizeof(int));
+    writer.add(SnapshotTag::EdgeDest, g.edgeDest.data(), g.edgeDest.size() * sizeof(int));
+    writer.add(SnapshotTag::EdgeWeight, g.edgeWeight.data(), g.edgeWeight.size() * sizeof(int));
+    writer.add(SnapshotTag::RevOffsets, g.revOffsets.data(), g.revOffsets.size() * sizeof(int));
+    writer.add(SnapshotTag::RevSrc, g.revSrc.data(), g.revSrc.size() * sizeof(int));
+    writer.add(SnapshotTag::RevWeight, g.revWeight.data(), g.revWeight.size() * sizeof(int));
+    writer.add(SnapshotTag::WeightRange, weightRange, sizeof(weightRange));
+    if (!alt.landmarks.empty())
+    {
+        writer.add(SnapshotTag::Landmarks, alt.landmarks.data(), alt.landmarks.size() * sizeof(int));
+        writer.add(SnapshotTag::FromLandmark, alt.fromLandmark.data(), alt.fromLandmark.size() * sizeof(int));
+        if (!alt.toLandmark.empty())
+        {
+            writer.add(SnapshotTag::ToLandmark, alt.toLandmark.data(), alt.toLandmark.size() * sizeof(int));
+        }
+    }
+    return writer.save(filename, source);
+}
+
+// The checksum only catches accidental damage, so the loaders also check
+// that a snapshot cannot send the solvers out of bounds. offsets[0..n] must
+// start at 0, never decrease and end at total.
+bool validOffsets(const int *offsets, size_t n, size_t total)
+{
+    if (offsets[0] != 0 || (size_t)offsets[n] != total)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (offsets[i] > offsets[i + 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// every ids[i * step] is a vertex below V
+bool validVertices(const int *ids, size_t n, size_t V, size_t step = 1)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (ids[i * step] < 0 || (size_t)ids[i * step] >= V)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Points g (and alt, if given and the snapshot has landmarks) at the arrays
+// inside the mapped snapshot; nothing is copied. The arrays are validated
+// first: a false return makes the caller parse the text file instead.
+bool loadGraphSnapshot(const string &filename, const string &source, DijkstraGraph &g, LandmarkIndex *alt)
+{
+    GraphSnapshot snapshot;
+    if (!snapshot.open(filename, source))
+    {
+        return false;
+    }
+
+    size_t V = (size_t)snapshot.header.vertices;
+    size_t E = (size_t)snapshot.header.edges;
+    size_t counts[7];
+    const int *offsets = snapshot.ints(SnapshotTag::Offsets, counts[0]);
+    const int *dest = snapshot.ints(SnapshotTag::EdgeDest, counts[1]);
+    const int *weight = snapshot.ints(SnapshotTag::EdgeWeight, counts[2]);
+    const int *revOffsets = snapshot.ints(SnapshotTag::RevOffsets, counts[3]);
+    const int *revSrc = snapshot.ints(SnapshotTag::RevSrc, counts[4]);
+    const int *revWeight = snapshot.ints(SnapshotTag::RevWeight, counts[5]);
+    const int *weightRange = snapshot.ints(SnapshotTag::WeightRange, counts[6]);
+    if (V == 0 || V >= INT_MAX || counts[0] != V + 1 || counts[3] != V + 1 || counts[1] != E || counts[2] != E ||
+        counts[4] != E || counts[5] != E || counts[6] != 2 || (size_t)offsets[V] != E || (size_t)revOffsets[V] != E)
+    {
+        cout << filename << " does not hold a complete graph." << endl;
+        return false;
+    }
+
+    // the weight range picks the queue, so it must be the one freeze() would compute
+    int low = E > 0 ? INT_MAX : 0, high = 0;
+    for (size_t i = 0; i < E; ++i)
+    {
+        low = min(low, weight[i]);
+        high = max(high, weight[i]);
+    }
+    bool reverseInRange = true;
+    for (size_t i = 0; i < E; ++i)
+    {
+        reverseInRange &= revWeight[i] >= low && revWeight[i] <= high;
+    }
+    size_t k, fromCount, toCount;
+    const int *ids = snapshot.ints(SnapshotTag::Landmarks, k);
+    const int *from = snapshot.ints(SnapshotTag::FromLandmark, fromCount);
+    const int *to = snapshot.ints(SnapshotTag::ToLandmark, toCount);
+    if (!validOffsets(offsets, V, E) || !validOffsets(revOffsets, V, E) || !validVertices(dest, E, V) ||
+        !validVertices(revSrc, E, V) || weightRange[0] != low || weightRange[1] != high || !reverseInRange ||
+        (ids != nullptr && !validVertices(ids, k, V)))
+    {
+        cout << filename << " does not hold a valid graph." << endl;
+        return false;
+    }
+
+    g = DijkstraGraph(0);
+    g.V = (int)V;
+    g.offsets.borrow(offsets, V + 1);
+    g.edgeDest.borrow(dest, E);
+    g.edgeWeight.borrow(weight, E);
+    g.revOffsets.borrow(revOffsets, V + 1);
+    g.revSrc.borrow(revSrc, E);
+    g.revWeight.borrow(revWeight, E);
+    g.minWeight = weightRange[0];
+    g.maxWeight = weightRange[1];
+    g.frozen = true;
+    g.mapping = snapshot.file;
+
+    if (alt != nullptr && k > 0 && fromCount == V * k && (to == nullptr || toCount == V * k))
+    {
+        alt->useTables(vector<int>(ids, ids + k), (int)V, from, to, snapshot.file);
+    }
+    return true;
+}
+
+// streaming bellman-ford
+//
+// For edge files larger than memory: only dist stays resident, and every
+// pass streams the edges from disk again in large sequential reads. A
+// pass works on one block while the next block is read (and, for text
+// files, parsed) by a background task, so I/O overlaps relaxation. Passes
+// stop as soon as one changes nothing. Both the numeric text format and the
+// road list of a city snapshot can be streamed; the snapshot checksum is not
+// verified, since that would cost a whole extra pass.
+const size_t STREAM_BLOCK_BYTES = (size_t)16 << 20;
+
+struct StreamStats
+{
+    int passes = 0;
+    long long edgesRelaxed = 0;
+    long long improvements = 0;
+    long long bytesRead = 0;
+    long long micros = 0;
+};
+
+// "V E" then "u v w" lines, read in STREAM_BLOCK_BYTES pieces cut at newlines.
+class TextEdgeStream
+{
+public:
+    int V = 0;
+    long long E = 0;
+    bool failed = false;
+    long long bytesRead = 0;
+
+    bool open(const string &filename);
+    void rewind();
+    // Fills block with the next edges; false once all E edges were returned
+    // or the file turned out to be bad (failed is set then).
+    bool next(vector<bellEdges> &block);
+
+private:
+    string name;
+    ifstream file;
+    streamoff firstEdge = 0;
+    vector<char> buffer;
+    size_t carried = 0;
+    long long delivered = 0;
+    EdgeChunk chunk;
+};
+
+bool TextEdgeStream::open(const string &filename)
+{
+    name = filename;
+    file.open(filename, ios::binary);
+    if (!file)
+    {
+        cerr << "Unable to open file " << filename << endl;
+        return false;
+    }
+    // the counts may share a line or not, so read lines until both are there
+    string line, header;
+    bool haveCounts = false;
+    while (!haveCounts && getline(file, line))
+    {
+        header += line + ' ';
+        istringstream counts(header);
+        haveCounts = (bool)(counts >> V >> E);
+    }
+    if (!haveCounts || V <= 0 || E < 0)
+    {
+        cout << "Invalid number of vertices or edges in the file." << endl;
+        return false;
+    }
+    firstEdge = file.tellg();
+    buffer.resize(STREAM_BLOCK_BYTES);
+    return true;
+}
+
+void TextEdgeStream::rewind()
+{
+    file.clear();
+    file.seekg(firstEdge);
+    carried = 0;
+    delivered = 0;
+    failed = false;
+}
+
+bool TextEdgeStream::next(vector<bellEdges> &block)
+{
+    block.clear();
+    while (block.empty() && delivered < E && !failed)
+    {
+        file.read(buffer.data() + carried, buffer.size() - carried);
+        size_t got = (size_t)file.gcount();
+        bytesRead += got;
+        size_t filled = carried + got;
+        if (filled == 0)
+        {
+            cout << name << " ends after " << delivered << " of " << E << " edges." << endl;
+            failed = true;
+            break;
+        }
+
+        // parse whole lines only; the tail of an unfinished line is carried over
+        size_t cut = filled;
+        if (got > 0)
+        {
+            const char *newline = nullptr;
+            for (size_t i = filled; i > 0 && newline == nullptr; --i)
+            {
+                if (buffer[i - 1] == '\n')
+                {
+                    newline = buffer.data() + i - 1;
+                }
+            }
+            if (newline == nullptr && filled == buffer.size())
+            {
+                cout << "Line longer than " << buffer.size() << " bytes in " << name << "." << endl;
+                failed = true;
+                break;
+            }
+            cut = newline == nullptr ? 0 : (size_t)(newline - buffer.data()) + 1;
+        }
+
+        chunk.edges.swap(block);
+        chunk.edges.clear();
+        chunk.malformed = false;
+        chunk.badRange = -1;
+        parseEdgeChunk(buffer.data(), buffer.data(), buffer.data() + cut, V, chunk);
+        chunk.edges.swap(block);
+
+        long long wanted = E - delivered;
+        if (chunk.badRange >= 0 && chunk.badRange < wanted)
+        {
+            cout << "Invalid edge in the file. Vertex indices must be between 0 and " << V - 1 << "." << endl;
+            failed = true;
+            break;
+        }
+        if (chunk.malformed && (long long)block.size() < wanted)
+        {
+            cout << "Malformed edge in " << name << "." << endl;
+            failed = true;
+            break;
+        }
+        if ((long long)block.size() > wanted)
+        {
+            block.resize(wanted);
+        }
+        delivered += block.size();
+
+        copy(buffer.begin() + cut, buffer.begin() + filled, buffer.begin());
+        carried = filled - cut;
+    }
+    if (failed)
+    {
+        block.clear();
+    }
+    return !block.empty();
+}
+
+// The road list section of a city snapshot, read straight into the block.
+class SnapshotEdgeStream
+{
+public:
+    int V = 0;
+    long long E = 0;
+    bool failed = false;
+    long long bytesRead = 0;
+
+    bool open(const string &filename);
+    void rewind();
+    bool next(vector<bellEdges> &block);
+
+private:
+    ifstream file;
+    uint64_t firstEdge = 0;
+    long long delivered = 0;
+};
+
+bool SnapshotEdgeStream::open(const string &filename)
+{
+    file.open(filename, ios::binary);
+    if (!file)
+    {
+        cerr << "Unable to open file " << filename << endl;
+        return false;
+    }
+    SnapshotHeader header;
+    file.read((char *)&header, sizeof(header));
+    if (!file || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.byteOrder != SNAPSHOT_BYTE_ORDER || header.version != SNAPSHOT_VERSION)
+    {
+        cout << filename << " is not a snapshot this build can read." << endl;
+        return false;
+    }
+    for (uint32_t s = 0; s < header.sections; ++s)
+    {
+        SnapshotSection entry;
+        file.read((char *)&entry, sizeof(entry));
+        if (file && entry.tag == (uint32_t)SnapshotTag::Edges)
+        {
+            V = (int)min<uint64_t>(header.vertices, INT_MAX);
+            E = (long long)(entry.bytes / sizeof(bellEdges));
+            firstEdge = entry.offset;
+            return V > 0;
+        }
+    }
+    cout << filename << " has no road list." << endl;
+    return false;
+}
+
+void SnapshotEdgeStream::rewind()
+{
+    file.clear();
+    file.seekg((streamoff)firstEdge);
+    delivered = 0;
+    failed = false;
+}
+
+bool SnapshotEdgeStream::next(vector<bellEdges> &block)
+{
+    size_t count = (size_t)min<long long>(E - delivered, STREAM_BLOCK_BYTES / sizeof(bellEdges));
+    block.resize(count);
+    if (count == 0)
+    {
+        return false;
+    }
+    file.read((char *)block.data(), count * sizeof(bellEdges));
+    bytesRead += file.gcount();
+    if ((size_t)file.gcount() != count * sizeof(bellEdges))
+    {
+        cout << "Snapshot ends after " << delivered << " of " << E << " roads." << endl;
+        failed = true;
+        block.clear();
+        return false;
+    }
+    for (const bellEdges &edge : block)
+    {
+        if (edge.src < 0 || edge.src >= V || edge.dest < 0 || edge.dest >= V)
+        {
+            cout << "Invalid road in the snapshot." << endl;
+            failed = true;
+            block.clear();
+            return false;
+        }
+    }
+    delivered += count;
+    return true;
+}
+
+// One pass over the stream: relaxes the current block while the next one is
+// read in the background. Returns whether any distance dropped.
+template <class Stream>
+bool streamPass(Stream &stream, vector<int> &dist, StreamStats &stats, vector<bellEdges> &front, vector<bellEdges> &back)
+{
+    stream.rewind();
+    bool changed = false;
+    bool more = stream.next(front);
+    while (more)
+    {
+        future<bool> pending = async(launch::async, [&stream, &back]()
+                                     { return stream.next(back); });
+        for (const bellEdges &edge : front)
+        {
+            int du = dist[edge.src];
+            if (du != INT_MAX && du + edge.weight < dist[edge.dest])
+            {
+                dist[edge.dest] = du + edge.weight;
+                ++stats.improvements;
+                changed = true;
+            }
+        }
+        stats.edgesRelaxed += front.size();
+        more = pending.get();
+        front.swap(back);
+    }
+    return changed;
+}
+
+// Bellman-Ford from src with the edges streamed on every pass. Returns false
+// on a negative cycle or a bad file (stream.failed tells which).
+template <class Stream>
+bool streamBellmanFord(Stream &stream, int src, vector<int> &dist, StreamStats &stats)
+{
+    auto start = high_resolution_clock::now();
+    dist.assign(stream.V, INT_MAX);
+    dist[src] = 0;
+
+    vector<bellEdges> front, back;
+    bool changed = true;
+    for (int pass = 1; pass <= stream.V - 1 && changed && !stream.failed; ++pass)
+    {
+        ++stats.passes;
+        changed = streamPass(stream, dist, stats, front, back);
+    }
+
+    // a pass that still changes something after V - 1 passes means a negative cycle
+    bool ok = !stream.failed;
+    if (ok && changed)
+    {
+        ++stats.passes;
+        ok = !streamPass(stream, dist, stats, front, back) && !stream.failed;
+    }
+    stats.bytesRead = stream.bytesRead;
+    stats.micros = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+    return ok;
+}
+
+void printStreamStats(const StreamStats &stats)
+{
+    double megabytes = stats.bytesRead / (1024.0 * 1024.0);
+    double seconds = max(stats.micros, 1LL) / 1e6;
+    cout << stats.passes << " passes over " << stats.edgesRelaxed << " edges, " << stats.improvements
+         << " improvements, " << megabytes << " MB read in " << stats.micros / 1000 << " ms ("
+         << megabytes / seconds << " MB/s)" << endl;
+}
+
+template <class Stream>
+void streamFromFile(Stream &stream, const string &filename)
+{
+    if (!stream.open(filename))
+    {
+        return;
+    }
+
+    int src;
+    cout << "Enter the starting location: ";
+    cin >> src;
+    if (src < 0 || src >= stream.V)
+    {
+        cout << "Invalid starting location." << endl;
+        return;
+    }
+
+    vector<int> dist;
+    StreamStats stats;
+    bool ok = streamBellmanFord(stream, src, dist, stats);
+    if (stream.failed)
+    {
+        return;
+    }
+    if (!ok)
+    {
+        cout << "Graph contains negative weight cycle" << endl;
+        return;
+    }
+    printStreamStats(stats);
+
+    const int printLimit = 20;
+    for (int i = 0; i < min(stream.V, printLimit); ++i)
+    {
+        if (dist[i] == INT_MAX)
+        {
+            cout << "Location " << i << " is unreachable" << endl;
+        }
+        else
+        {
+            cout << "To location " << i << " : " << dist[i] << " units" << endl;
+        }
+    }
+    if (stream.V > printLimit)
+    {
+        cout << "... " << stream.V - printLimit << " more locations" << endl;
+    }
+}
+
+// Edge files ending in .snap are streamed as city snapshots, anything else as text.
+void streamBellmanFordOnFile()
+{
+    string filename;
+    cout << "Enter the edge file to stream: ";
+    cin >> filename;
+
+    if (filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".snap") == 0)
+    {
+        SnapshotEdgeStream stream;
+        streamFromFile(stream, filename);
+    }
+    else
+    {
+        TextEdgeStream stream;
+        streamFromFile(stream, filename);
+    }
+}
+
+// incremental shortest paths
+//
+// DynamicShortestPaths keeps the distances and the shortest path tree of one
+// source while roads are added, removed or change weight, in the manner of
+// Ramalingam and Reps. Lowering the weight of u -> v (or adding it) can only
+// improve v and what hangs below it, so improvements are propagated from v
+// with a heap and stop where nothing gets shorter. Raising or removing a road
+// matters only if it is v's tree edge: then the subtree under v loses its
+// distances, each of its vertices takes the best offer from an in-road
+// outside the subtree, and the heap settles the rest of the subtree. Either
+// way the work is bounded by the region that actually changes. Negative
+// weights are fine; an update that makes a negative cycle reachable (the
+// improvement reaches u again, or a tree path grows to V edges) is rolled
+// back and reported as rejected.
+// Parallel roads are collapsed to the lightest one when loading.
+struct UpdateStats
+{
+    long long affected = 0;     // vertices whose distance was reset or lowered
+    long long changed = 0;      // vertices whose distance ended up different
+    long long heapPops = 0;
+    long long edgesScanned = 0;
+    long long micros = 0;
+    bool rejected = false;
+};
+
+class DynamicShortestPaths
+{
+public:
+    int V = 0, src = 0;
+    vector<int> dist;
+    vector<int> parent; // tree predecessor, -1 for src and unreachable vertices
+    vector<int> hops;   // edges on the tree path from src
+
+    bool build(BellmanFordGraph &g, int src);
+    UpdateStats setWeight(int u, int v, int w); // adds the road if it is missing
+    UpdateStats removeEdge(int u, int v);
+    int weight(int u, int v) const;
+    bool matchesRecompute(long long &micros);
+
+private:
+    struct Arc
+    {
+        int to;
+        int weight;
+    };
+
+    struct Saved
+    {
+        int v, dist, parent, hops;
+    };
+
+    vector<vector<Arc>> out, in; // in-arcs store the tail in to
+    LazyHeap heap;
+    vector<unsigned> savedIn;    // epoch of the update that saved v
+    unsigned epoch = 0;
+    vector<Saved> saved;         // undo log of the current update
+    UpdateStats stats;
+
+    void begin();
+    void save(int v);
+    void finish(high_resolution_clock::time_point start);
+    void rollback();
+    bool propagate(int tail);
+    void lowered(int u, int v, int w);
+    void raised(int u, int v);
+    static Arc *findArc(vector<Arc> &arcs, int to);
+};
+
+DynamicShortestPaths::Arc *DynamicShortestPaths::findArc(vector<Arc> &arcs, int to)
+{
+    for (Arc &arc : arcs)
+    {
+        if (arc.to == to)
+        {
+            return &arc;
+        }
+    }
+    return nullptr;
+}
+
+int DynamicShortestPaths::weight(int u, int v) const
+{
+    for (const Arc &arc : out[u])
+    {
+        if (arc.to == v)
+        {
+            return arc.weight;
+        }
+    }
+    return INT_MAX;
+}
+
+// Solves g from src once; false if a negative cycle is reachable.
+bool DynamicShortestPaths::build(BellmanFordGraph &g, int src)
+{
+    BellmanStats check;
+    if (!g.solve(src, selectedBellmanMode, dist, check))
+    {
+        return false;
+    }
+
+    V = g.V;
+    this->src = src;
+    out.assign(V, {});
+    in.assign(V, {});
+    for (int j = 0; j < g.E; ++j)
+    {
+        const bellEdges &edge = g.edges[j];
+        Arc *arc = findArc(out[edge.src], edge.dest);
+        if (!arc)
+        {
+            out[edge.src].push_back({edge.dest, edge.weight});
+            in[edge.dest].push_back({edge.src, edge.weight});
+        }
+        else if (edge.weight < arc->weight)
+        {
+            arc->weight = edge.weight;
+            findArc(in[edge.dest], edge.src)->weight = edge.weight;
+        }
+    }
+
+    // the tree comes from one label-correcting run, whose last-improvement
+    // predecessors form a tree when there is no negative cycle
+    dist.assign(V, INT_MAX);
+    parent.assign(V, -1);
+    hops.assign(V, 0);
+    savedIn.assign(V, 0);
+    dist[src] = 0;
+    heap.reset(V);
+    heap.push(src, 0);
+    begin();
+    propagate(-1);
+    return true;
+}
+
+void DynamicShortestPaths::begin()
+{
+    stats = UpdateStats();
+    saved.clear();
+    if (++epoch == 0)
+    {
+        fill(savedIn.begin(), savedIn.end(), 0);
+        epoch = 1;
+    }
+}
+
+void DynamicShortestPaths::save(int v)
+{
+    if (savedIn[v] != epoch)
+    {
+        savedIn[v] = epoch;
+        saved.push_back({v, dist[v], parent[v], hops[v]});
+        ++stats.affected;
+    }
+}
+
+void DynamicShortestPaths::finish(high_resolution_clock::time_point start)
+{
+    for (const Saved &entry : saved)
+    {
+        stats.changed += dist[entry.v] != entry.dist;
+    }
+    stats.micros = microsSince(start);
+}
+
+void DynamicShortestPaths::rollback()
+{
+    for (const Saved &entry : saved)
+    {
+        dist[entry.v] = entry.dist;
+        parent[entry.v] = entry.parent;
+        hops[entry.v] = entry.hops;
+    }
+    saved.clear();
+    stats.rejected = true;
+}
+
+// Settles the heap, relaxing out-roads of every popped vertex. Returns false
+// on a negative cycle: as soon as tail would improve, or a path reaches V edges.
+bool DynamicShortestPaths::propagate(int tail)
+{
+    while (!heap.empty())
+    {
+        int d;
+        int x = heap.pop(d);
+        ++stats.heapPops;
+        if (d > dist[x])
+        {
+            continue;
+        }
+        stats.edgesScanned += out[x].size();
+        for (const Arc &arc : out[x])
+        {
+            int candidate = d + arc.weight;
+            if (candidate < dist[arc.to])
+            {
+                if (arc.to == tail || hops[x] + 1 >= V)
+                {
+                    return false;
+                }
+                save(arc.to);
+                dist[arc.to] = candidate;
+                parent[arc.to] = x;
+                hops[arc.to] = hops[x] + 1;
+                heap.push(arc.to, candidate);
+            }
+        }
+    }
+    return true;
+}
+
+// u -> v now weighs w, which is less than before (or it is new)
+void DynamicShortestPaths::lowered(int u, int v, int w)
+{
+    if (dist[u] == INT_MAX || dist[u] + w >= dist[v])
+    {
+        return;
+    }
+    if (u == v)
+    {
+        stats.rejected = true; // negative self-loop
+        return;
+    }
+    save(v);
+    dist[v] = dist[u] + w;
+    parent[v] = u;
+    hops[v] = hops[u] + 1;
+    heap.reset(V);
+    heap.push(v, dist[v]);
+    if (!propagate(u))
+    {
+        rollback();
+    }
+}
+
+// u -> v got heavier or was removed
+void DynamicShortestPaths::raised(int u, int v)
+{
+    if (parent[v] != u)
+    {
+        return; // not a tree edge, nobody's distance used it
+    }
+
+    // the subtree under v, found by walking tree edges down from it
+    vector<int> subtree(1, v);
+    save(v);
+    for (size_t i = 0; i < subtree.size(); ++i)
+    {
+        int x = subtree[i];
+        stats.edgesScanned += out[x].size();
+        for (const Arc &arc : out[x])
+        {
+            if (parent[arc.to] == x && savedIn[arc.to] != epoch)
+            {
+                save(arc.to);
+                subtree.push_back(arc.to);
+            }
+        }
+    }
+    for (int x : subtree)
+    {
+        dist[x] = INT_MAX;
+        parent[x] = -1;
+    }
+
+    // best entry into the subtree from outside it
+    heap.reset(V);
+    for (int x : subtree)
+    {
+        stats.edgesScanned += in[x].size();
+        for (const Arc &arc : in[x])
+        {
+            int y = arc.to;
+            if (dist[y] != INT_MAX && dist[y] + arc.weight < dist[x])
+            {
+                dist[x] = dist[y] + arc.weight;
+                parent[x] = y;
+                hops[x] = hops[y] + 1;
+            }
+        }
+        if (dist[x] != INT_MAX)
+        {
+            heap.push(x, dist[x]);
+        }
+    }
+    propagate(-1);
+}
+
+UpdateStats DynamicShortestPaths::setWeight(int u, int v, int w)
+{
+    auto start = high_resolution_clock::now();
+    begin();
+
+    Arc *arc = findArc(out[u], v);
+    int old = arc ? arc->weight : INT_MAX;
+    if (w == old)
+    {
+        finish(start);
+        return stats;
+    }
+    if (arc)
+    {
+        arc->weight = w;
+        findArc(in[v], u)->weight = w;
+    }
+    else
+    {
+        out[u].push_back({v, w});
+        in[v].push_back({u, w});
+    }
+
+    if (w < old)
+    {
+        lowered(u, v, w);
+        if (stats.rejected)
+        {
+            // put the road back the way it was
+            if (arc)
+            {
+                findArc(out[u], v)->weight = old;
+                findArc(in[v], u)->weight = old;
+            }
+            else
+            {
+                out[u].pop_back();
+                in[v].pop_back();
+            }
+        }
+    }
+    else
+    {
+        raised(u, v);
+    }
+    finish(start);
+    return stats;
+}
+
+UpdateStats DynamicShortestPaths::removeEdge(int u, int v)
+{
+    auto start = high_resolution_clock::now();
+    begin();
+
+    Arc *arc = findArc(out[u], v);
+    if (arc)
+    {
+        *arc = out[u].back();
+        out[u].pop_back();
+        Arc *back = findArc(in[v], u);
+        *back = in[v].back();
+        in[v].pop_back();
+        raised(u, v);
+    }
+    finish(start);
+    return stats;
+}
+
+// Runs classic Bellman-Ford on the current roads and compares distances.
+bool DynamicShortestPaths::matchesRecompute(long long &micros)
+{
+    size_t roads = 0;
+    for (const vector<Arc> &arcs : out)
+    {
+        roads += arcs.size();
+    }
+    BellmanFordGraph g(V, (int)roads);
+    int j = 0;
+    for (int u = 0; u < V; ++u)
+    {
+        for (const Arc &arc : out[u])
+        {
+            g.edges[j++] = {u, arc.to, arc.weight};
+        }
+    }
+
+    auto start = high_resolution_clock::now();
+    vector<int> reference;
+    BellmanStats unused;
+    bool ok = g.solve(src, BellmanMode::Frontier, reference, unused);
+    micros = microsSince(start);
+    return ok && reference == dist;
+}
+
+void printUpdateStats(const UpdateStats &stats)
+{
+    if (stats.rejected)
+    {
+        cout << "Rejected: the change would create a negative weight cycle" << endl;
+        return;
+    }
+    cout << "Updated in " << stats.micros << " microseconds: " << stats.affected << " locations affected, "
+         << stats.changed << " distances changed, " << stats.heapPops << " heap pops, " << stats.edgesScanned
+         << " roads scanned" << endl;
+}
+
+bool readMapFile(const string &filename, BellmanFordGraph &g)
+{
+    EdgeListFile file;
+    if (!readEdgeListFile(filename, file))
+    {
+        return false;
+    }
+    printParseRate(file);
+
+    g = BellmanFordGraph(file.V, 0);
+    g.E = file.E;
+    g.edges = move(file.edges);
+    g.phases.load = file.micros;
+    return true;
+}
+
+void loadMapFromFile(BellmanFordGraph &g)
+{
+    if (!readMapFile("bellManFord.txt", g))
+    {
+        return;
+    }
+
+    int src;
+    vector<int> targets;
+    while (nextSource("Enter the starting location", g.V, src))
+    {
+        if (readRouteTargets("location", g.V, targets))
+        {
+            g.bellmanFord(src, targets);
+        }
+    }
+}
+
+// Solves the file map once, then applies road changes typed in one at a time:
+// "set u v w" adds or reweights a road, "remove u v" deletes it, "dist v"
+// shows a distance, "check" compares against a full recompute and "done" ends.
+void liveTrafficOnFile()
+{
+    BellmanFordGraph g(0, 0);
+    if (!readMapFile("bellManFord.txt", g))
+    {
+        return;
+    }
+
+    int src;
+    cout << "Enter the starting location: ";
+    cin >> src;
+    if (src < 0 || src >= g.V)
+    {
+        cout << "Invalid starting location." << endl;
+        return;
+    }
+
+    DynamicShortestPaths live;
+    auto start = high_resolution_clock::now();
+    if (!live.build(g, src))
+    {
+        cout << "Graph contains negative weight cycle" << endl;
+        return;
+    }
+    cout << "Solved from location " << src << " in " << microsSince(start) << " microseconds" << endl;
+
+    string command;
+    while (true)
+    {
+        cout << "Update (set u v w, remove u v, dist v, check, done): ";
+        if (!(cin >> command) || command == "done")
+        {
+            return;
+        }
+
+        int u, v, w;
+        if (command == "set" && cin >> u >> v >> w && u >= 0 && u < g.V && v >= 0 && v < g.V)
+        {
+            printUpdateStats(live.setWeight(u, v, w));
+        }
+        else if (command == "remove" && cin >> u >> v && u >= 0 && u < g.V && v >= 0 && v < g.V)
+        {
+            printUpdateStats(live.removeEdge(u, v));
+        }
+        else if (command == "dist" && cin >> v && v >= 0 && v < g.V)
+        {
+            if (live.dist[v] == INT_MAX)
+            {
+                cout << "Location " << v << " is unreachable" << endl;
+            }
+            else
+            {
+                cout << "To location " << v << " : " << live.dist[v] << " units" << endl;
+            }
+        }
+        else if (command == "check")
+        {
+            long long micros;
+            bool same = live.matchesRecompute(micros);
+            cout << (same ? "Matches" : "Differs from") << " a full recompute (" << micros << " microseconds)" << endl;
+        }
+        else
+        {
+            cout << "Invalid update." << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        }
+    }
+}
+
+// Solves from src with the array-of-structs sweep and the structure-of-arrays
+// store under every kernel the CPU supports, reporting edge throughput and
+// checking the distances agree.
+void benchmarkRelaxKernels(BellmanFordGraph &g, int src)
+{
+    const int repetitions = 5;
+    g.buildSoA();
+
+    vector<int> reference;
+    BellmanStats stats;
+    bool ok = g.solve(src, BellmanMode::Classic, reference, stats);
+    if (!ok)
+    {
+        cout << "Graph contains negative weight cycle" << endl;
+        return;
+    }
+
+    auto report = [&](const string &name, long long micros, const BellmanStats &run, bool same)
+    {
+        double edgesPerSecond = micros > 0 ? run.edgesScanned * 1e6 / micros : 0;
+        cout << name << ": " << micros << " microseconds, " << run.rounds << " rounds, "
+             << edgesPerSecond / 1e6 << " M edges/s" << (same ? "" : " (distances differ!)") << endl;
+    };
+
+    long long best = LLONG_MAX;
+    for (int r = 0; r < repetitions; ++r)
+    {
+        vector<int> dist;
+        auto start = high_resolution_clock::now();
+        g.solve(src, BellmanMode::Classic, dist, stats);
+        auto stop = high_resolution_clock::now();
+        best = min(best, (long long)duration_cast<microseconds>(stop - start).count());
+    }
+    report("array of structs", best, stats, true);
+
+    const RelaxKernel kernels[] = {RelaxKernel::Scalar, RelaxKernel::Avx2, RelaxKernel::Avx512};
+    for (RelaxKernel kernel : kernels)
+    {
+        if (!relaxKernelSupported(kernel))
+        {
+            cout << relaxKernelName(kernel) << ": not supported on this CPU" << endl;
+            continue;
+        }
+        vector<int> dist;
+        best = LLONG_MAX;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            stats = BellmanStats();
+            dist.assign(g.V, INT_MAX);
+            dist[src] = 0;
+            auto start = high_resolution_clock::now();
+            g.solveSimd(dist, stats, kernel);
+            auto stop = high_resolution_clock::now();
+            best = min(best, (long long)duration_cast<microseconds>(stop - start).count());
+        }
+        report("structure of arrays, " + relaxKernelName(kernel), best, stats, dist == reference);
+    }
+}
+
+void benchmarkKernelsOnFile()
+{
+    BellmanFordGraph g(0, 0);
+    if (!readMapFile("bellManFord.txt", g))
+    {
+        return;
+    }
+
+    int src;
+    cout << "Enter the starting location: ";
+    cin >> src;
+
+    if (src < 0 || src >= g.V)
+    {
+        cout << "Invalid starting location." << endl;
+        return;
+    }
+
+    benchmarkRelaxKernels(g, src);
+}
+
+string toLower(const string &str)
+{
+    string lowerStr;
+    transform(str.begin(), str.end(), back_inserter(lowerStr), ::tolower);
+    return lowerStr;
+}
+
+// Reads the named road format of citysList.txt: the city count and names,
+// then the road count and "from to length" lines. Names are matched without
+// case; the trailing start city line is left for the caller.
+bool readCityText(const string &filename, vector<string> &cities, unordered_map<string, int> &cityIndex, BellmanFordGraph &g)
+{
+    ifstream file(filename);
+    if (!file)
+    {
+        cerr << "Unable to open file " << filename << endl;
+        return false;
+    }
+
+    int numCities, numRoads;
+    file >> numCities;
+    if (!file || numCities <= 0)
+    {
+        cout << "Invalid number of cities in the file." << endl;
+        return false;
+    }
+
+    cities.resize(numCities);
+    cityIndex.clear();
+    for (int i = 0; i < numCities; ++i)
+    {
+        file >> cities[i];
+        cityIndex[toLower(cities[i])] = i;
+    }
+
+    file >> numRoads;
+    if (!file || numRoads < 0)
+    {
+        cout << "Invalid number of roads in the file." << endl;
+        return false;
+    }
+
+    g = BellmanFordGraph(numCities, numRoads);
+    for (int i = 0; i < numRoads; ++i)
+    {
+        string from, to;
+        int length;
+        file >> from >> to >> length;
+
+        auto u = cityIndex.find(toLower(from));
+        auto v = cityIndex.find(toLower(to));
+        if (!file || u == cityIndex.end() || v == cityIndex.end())
+        {
+            cout << "Invalid road " << i + 1 << " in the file: unknown city." << endl;
+            return false;
+        }
+        g.addEdge(u->second, v->second, length, i);
+    }
+    return true;
+}
+
+static_assert(sizeof(bellEdges) == 3 * sizeof(int), "city snapshots store roads as int triples");
+
+bool saveCitySnapshot(const string &filename, const string &source, const vector<string> &cities, const BellmanFordGraph &g)
+{
+    vector<int> nameOffsets(1, 0);
+    string nameChars;
+    for (const string &city : cities)
+    {
+        nameChars += city;
+        nameOffsets.push_back((int)nameChars.size());
+    }
+
+    SnapshotWriter writer;
+    writer.vertices = g.V;
+    writer.edges = g.E;
+    writer.add(SnapshotTag::NameOffsets, nameOffsets.data(), nameOffsets.size() * sizeof(int));
+    writer.add(SnapshotTag::NameChars, nameChars.data(), nameChars.size());
+    writer.add(SnapshotTag::Edges, g.edges.data(), g.edges.size() * sizeof(bellEdges));
+    return writer.save(filename, source);
+}
+
+// The Bellman-Ford engine owns its road list, so unlike graph snapshots the
+// roads are copied out of the mapping (one memcpy, no parsing).
+bool loadCitySnapshot(const string &filename, const string &source, vector<string> &cities,
+                      unordered_map<string, int> &cityIndex, BellmanFordGraph &g)
+{
+    GraphSnapshot snapshot;
+    if (!snapshot.open(filename, source))
+    {
+        return false;
+    }
+
+    size_t V = (size_t)snapshot.header.vertices;
+    size_t E = (size_t)snapshot.header.edges;
+    size_t offsetCount, charCount, edgeInts;
+    const int *nameOffsets = snapshot.ints(SnapshotTag::NameOffsets, offsetCount);
+    const char *nameChars = snapshot.section(SnapshotTag::NameChars, charCount);
+    const int *edges = snapshot.ints(SnapshotTag::Edges, edgeInts);
+    if (V == 0 || V >= INT_MAX || E >= INT_MAX || offsetCount != V + 1 || edgeInts != 3 * E ||
+        nameOffsets[V] < 0 || (size_t)nameOffsets[V] != charCount)
+    {
+        cout << filename << " does not hold a complete city list." << endl;
+        return false;
+    }
+    if (!validOffsets(nameOffsets, V, charCount) || !validVertices(edges, E, V, 3) || !validVertices(edges + 1, E, V, 3))
+    {
+        cout << filename << " does not hold a valid city list." << endl;
+        return false;
+    }
+
+    cities.resize(V);
+    cityIndex.clear();
+    for (size_t i = 0; i < V; ++i)
+    {
+        cities[i].assign(nameChars + nameOffsets[i], nameChars + nameOffsets[i + 1]);
+        cityIndex[toLower(cities[i])] = (int)i;
+    }
+    g = BellmanFordGraph((int)V, (int)E);
+    memcpy(g.edges.data(), edges, E * sizeof(bellEdges));
+    return true;
+}
+
+// Uses citysList.snap when it is current, and the text file otherwise.
+bool readCityFile(const string &filename, vector<string> &cities, unordered_map<string, int> &cityIndex, BellmanFordGraph &g)
+{
+    auto start = high_resolution_clock::now();
+    string snapshot = snapshotPathFor(filename);
+    if (loadCitySnapshot(snapshot, filename, cities, cityIndex, g))
+    {
+        auto stop = high_resolution_clock::now();
+        cout << "Loaded " << snapshot << " in " << duration_cast<microseconds>(stop - start).count() << " microseconds"
+             << endl;
+        return true;
+    }
+    return readCityText(filename, cities, cityIndex, g);
+}
+
+const string cityListFile = "citysList.txt";
+const string routeIndexFile = "citysList.ch";
+
+void saveCityListSnapshot()
+{
+    vector<string> cities;
+    unordered_map<string, int> cityIndex;
+    BellmanFordGraph g(0, 0);
+    if (!readCityText(cityListFile, cities, cityIndex, g))
+    {
+        return;
+    }
+
+    string snapshot = snapshotPathFor(cityListFile);
+    if (saveCitySnapshot(snapshot, cityListFile, cities, g))
+    {
+        cout << "Saved " << snapshot << " with " << g.V << " cities and " << g.E << " roads" << endl;
+    }
+}
+
+// Loads the saved route index if it was built from this exact map, otherwise
+// (or when forced) contracts the map again and saves the result.
+bool prepareRouteIndex(const BellmanFordGraph &g, ContractionHierarchy &ch, bool forceRebuild)
+{
+    if (!forceRebuild && ch.load(routeIndexFile) && ch.V == g.V && ch.fingerprint == ContractionHierarchy::graphFingerprint(g))
+    {
+        cout << "Loaded route index from " << routeIndexFile << endl;
+        return true;
+    }
+
+    auto start = high_resolution_clock::now();
+    if (!ch.build(g))
+    {
+        cout << "Route index needs non-negative road lengths." << endl;
+        return false;
+    }
+    auto stop = high_resolution_clock::now();
+
+    cout << "Built route index in " << duration_cast<milliseconds>(stop - start).count() << " ms, "
+         << ch.shortcuts << " shortcuts" << endl;
+    if (!ch.save(routeIndexFile))
+    {
+        cout << "Could not write " << routeIndexFile << endl;
+    }
+    return true;
+}
+
+void buildRouteIndex()
+{
+    vector<string> cities;
+    unordered_map<string, int> cityIndex;
+    BellmanFordGraph g(0, 0);
+    if (!readCityFile(cityListFile, cities, cityIndex, g))
+    {
+        return;
+    }
+
+    ContractionHierarchy ch;
+    prepareRouteIndex(g, ch, true);
+}
+
+// Loads the city list and its route index once, then answers city pairs
+// until "-" is entered, so every query after the first costs one CH search.
+void routeBetweenCities()
+{
+    vector<string> cities;
+    unordered_map<string, int> cityIndex;
+    BellmanFordGraph g(0, 0);
+    if (!readCityFile(cityListFile, cities, cityIndex, g))
+    {
+        return;
+    }
+
+    ContractionHierarchy ch;
+    if (!prepareRouteIndex(g, ch, false))
+    {
+        return;
+    }
+
+    string from, to;
+    while (true)
+    {
+        cout << "Enter the start city (- to go back): ";
+        if (!(cin >> from) || from == "-")
+        {
+            return;
+        }
+        cout << "Enter the destination city: ";
+        cin >> to;
+
+        auto u = cityIndex.find(toLower(from));
+        auto v = cityIndex.find(toLower(to));
+        if (u == cityIndex.end() || v == cityIndex.end())
+        {
+            cout << "Unknown city." << endl;
+            continue;
+        }
+
+        PointQueryStats stats;
+        auto start = high_resolution_clock::now();
+        int distance = ch.query(u->second, v->second, stats);
+        auto stop = high_resolution_clock::now();
+
+        if (distance == INT_MAX)
+        {
+            cout << cities[v->second] << " is unreachable from " << cities[u->second] << endl;
+        }
+        else
+        {
+            cout << "Distance from " << cities[u->second] << " to " << cities[v->second] << ": " << distance << " units"
+                 << endl;
+        }
+        cout << "Query took " << duration_cast<microseconds>(stop - start).count() << " microseconds, settled "
+             << stats.forwardSettled + stats.backwardSettled << " vertices" << endl;
+    }
+}
+
+// Distance matrix for the whole city list. Small lists are printed in full;
+// with --output-file every row goes to the file in the selected format. The
+// matrix is kept, so any number of city pairs are then answered by lookup.
+void allPairsForCities()
+{
+    vector<string> cities;
+    unordered_map<string, int> cityIndex;
+    BellmanFordGraph g(0, 0);
+    if (!readCityFile(cityListFile, cities, cityIndex, g))
+    {
+        return;
+    }
+
+    DistanceMatrix m;
+    ApspMethod method = ApspMethod::Auto;
+    auto start = high_resolution_clock::now();
+    bool ok = allPairsShortestPaths(g, m, method);
+    auto stop = high_resolution_clock::now();
+
+    if (!ok)
+    {
+        cout << "Graph contains negative weight cycle" << endl;
+        return;
+    }
+    cout << "All-pairs distances for " << g.V << " cities with " << apspMethodName(method) << " in "
+         << duration_cast<microseconds>(stop - start).count() << " microseconds" << endl;
+
+    const int printLimit = 20;
+    if (!outputFile.empty())
+    {
+        vector<int> row(g.V);
+        for (int i = 0; i < g.V; ++i)
+        {
+            for (int j = 0; j < g.V; ++j)
+            {
+                row[j] = m.at(i, j);
+            }
+            renderResult(i, row, "Shortest distances from " + cities[i] + ":", "city", " units");
+        }
+        cout << "Wrote " << g.V << " rows to " << outputFile << endl;
+    }
+    else if (g.V <= printLimit)
+    {
+        for (int i = 0; i < g.V; ++i)
+        {
+            cout << cities[i] << ":";
+            for (int j = 0; j < g.V; ++j)
+            {
+                if (m.at(i, j) == INT_MAX)
+                {
+                    cout << " -";
+                }
+                else
+                {
+                    cout << " " << m.at(i, j);
+                }
+            }
+            cout << endl;
+        }
+    }
+
+    string from, to;
+    while (true)
+    {
+        cout << "Enter the start city (- to go back): ";
+        if (!(cin >> from) || from == "-")
+        {
+            return;
+        }
+        cout << "Enter the destination city: ";
+        cin >> to;
+
+        auto u = cityIndex.find(toLower(from));
+        auto v = cityIndex.find(toLower(to));
+        if (u == cityIndex.end() || v == cityIndex.end())
+        {
+            cout << "Unknown city." << endl;
+            continue;
+        }
+        int distance = m.at(u->second, v->second);
+        if (distance == INT_MAX)
+        {
+            cout << cities[v->second] << " is unreachable from " << cities[u->second] << endl;
+        }
+        else
+        {
+            cout << "Distance from " << cities[u->second] << " to " << cities[v->second] << ": " << distance << " units"
+                 << endl;
+        }
+    }
+}
+
+void chooseBellmanMode()
+{
+    cout << "Current relaxation mode: " << bellmanModeName(selectedBellmanMode) << endl;
+    for (int i = 0; i < (int)size(allBellmanModes); ++i)
+    {
+        cout << i + 1 << ". " << bellmanModeName(allBellmanModes[i]) << endl;
+    }
+
+    int choice;
+    cout << "Enter your choice: ";
+    cin >> choice;
+
+    if (choice < 1 || choice > (int)size(allBellmanModes))
+    {
+        cout << "Invalid choice, keeping " << bellmanModeName(selectedBellmanMode) << "." << endl;
+        return;
+    }
+    selectedBellmanMode = allBellmanModes[choice - 1];
+    cout << "Using " << bellmanModeName(selectedBellmanMode) << "." << endl;
+}
+
+void displayBellmenFord()
+{
+    cout << "Main Menu:" << endl;
+    cout << "1. Input map manually" << endl;
+    cout << "2. Load map from file" << endl;
+    cout << "3. Choose relaxation mode" << endl;
+    cout << "4. Benchmark relaxation kernels on file map" << endl;
+    cout << "5. Build route index for city list" << endl;
+    cout << "6. Route between two cities" << endl;
+    cout << "7. All-pairs distances for city list" << endl;
+    cout << "8. Save city list as snapshot" << endl;
+    cout << "9. Stream Bellman-Ford over a large edge file" << endl;
+    cout << "10. Live road updates on file map" << endl;
+    cout << "11. Back to main " << endl;
+}
+
+// dijkstra
+void inputGraphManually()
+{
+    int V, E;
+    cout << "Enter the number of users (vertices): ";
+    cin >> V;
+
+    cout << "Enter the number of connections (edges): ";
+    cin >> E;
+
+    DijkstraGraph g(V);
+
+    for (int i = 0; i < E; ++i)
+    {
+        int u, v, w;
+        cout << "Connection " << i + 1 << " (user1 user2 weight): ";
+        cin >> u >> v >> w;
+        g.addEdge(u, v, w);
+    }
+    g.freeze();
+
+    int src;
+    while (nextSource("Enter the source user", V, src))
+    {
+        g.dijkstra(src);
+    }
+}
+
+bool readGraphText(const string &filename, DijkstraGraph &g)
+{
+    EdgeListFile file;
+    if (!readEdgeListFile(filename, file))
+    {
+        return false;
+    }
+    printParseRate(file);
+
+    auto start = high_resolution_clock::now();
+    g = DijkstraGraph(file.V);
+    g.freezeFrom(file.edges);
+    g.phases.load = file.micros;
+    g.phases.build = microsSince(start);
+    return true;
+}
+
+// Maps the snapshot next to filename when there is a current one and parses
+// the text file otherwise. alt, if given, receives the snapshot's landmarks.
+bool readGraphFile(const string &filename, DijkstraGraph &g, LandmarkIndex *alt = nullptr)
+{
+    auto start = high_resolution_clock::now();
+    string snapshot = snapshotPathFor(filename);
+    if (loadGraphSnapshot(snapshot, filename, g, alt))
+    {
+        g.phases.load = microsSince(start);
+        cout << "Mapped " << snapshot << " (" << g.V << " users, " << g.edgeDest.size() << " edges) in "
+             << g.phases.load << " microseconds" << endl;
+        return true;
+    }
+    return readGraphText(filename, g);
+}
+
+// Parses the text graph, picks landmarks with the current options and saves
+// both, so later loads map the arrays instead of parsing.
+void saveGraphSnapshotOnFile()
+{
+    const string source = "dijkstraInput.txt";
+    DijkstraGraph g(0);
+    if (!readGraphText(source, g))
+    {
+        return;
+    }
+
+    LandmarkIndex alt;
+    alt.build(g, landmarkOptions); // leaves no landmarks for negative weights
+
+    string snapshot = snapshotPathFor(source);
+    auto start = high_resolution_clock::now();
+    if (saveGraphSnapshot(snapshot, source, g, alt))
+    {
+        auto stop = high_resolution_clock::now();
+        cout << "Saved " << snapshot << " with " << g.V << " users, " << g.edgeDest.size() << " edges and "
+             << alt.landmarks.size() << " landmarks in " << duration_cast<milliseconds>(stop - start).count() << " ms"
+             << endl;
+    }
+}
+
+void loadGraphFromFile()
+{
+    DijkstraGraph g(0);
+    if (!readGraphFile("dijkstraInput.txt", g))
+    {
+        return; // Return gracefully if file cannot be opened
+    }
+
+    int src;
+    vector<int> targets;
+    while (nextSource("Enter the source user", g.V, src))
+    {
+        if (readRouteTargets("user", g.V, targets))
+        {
+            g.dijkstra(src, targets);
+        }
+    }
+}
+
+void chooseDijkstraQueue()
+{
+    cout << "Current priority queue: " << queueName(selectedQueue) << endl;
+    cout << "0. auto (pick from the weight range)" << endl;
+    for (int i = 0; i < (int)size(allQueues); ++i)
+    {
+        cout << i + 1 << ". " << queueName(allQueues[i]) << endl;
+    }
+
+    int choice;
+    cout << "Enter your choice: ";
+    cin >> choice;
+
+    if (choice == 0)
+    {
+        selectedQueue = QueueKind::Auto;
+    }
+    else if (choice >= 1 && choice <= (int)size(allQueues))
+    {
+        selectedQueue = allQueues[choice - 1];
+    }
+    else
+    {
+        cout << "Invalid choice, keeping " << queueName(selectedQueue) << "." << endl;
+        return;
+    }
+    cout << "Using " << queueName(selectedQueue) << "." << endl;
+}
+
+// Runs every queue on the file graph from one source so they can be compared.
+void compareQueuesOnFile()
+{
+    DijkstraGraph g(0);
+    if (!readGraphFile("dijkstraInput.txt", g))
+    {
+        return;
+    }
+
+    int src;
+    cout << "Enter the source user: ";
+    cin >> src;
+
+    if (src < 0 || src >= g.V)
+    {
+        cout << "Invalid source user." << endl;
+        return;
+    }
+
+    cout << "Weights range from " << g.minWeight << " to " << g.maxWeight
+         << ", auto picks " << queueName(g.resolveQueue(QueueKind::Auto)) << endl;
+
+    vector<int> reference;
+    for (QueueKind kind : allQueues)
+    {
+        if (g.resolveQueue(kind) != kind)
+        {
+            cout << queueName(kind) << ": skipped, does not fit this weight range" << endl;
+            continue;
+        }
+
+        vector<int> dist;
+        auto start = high_resolution_clock::now();
+        QueueStats stats = g.shortestPaths(src, kind, dist);
+        auto stop = high_resolution_clock::now();
+
+        cout << queueName(kind) << ": " << duration_cast<microseconds>(stop - start).count() << " microseconds" << endl;
+        printQueueStats(stats);
+
+        if (reference.empty())
+        {
+            reference = dist;
+        }
+        else if (dist != reference)
+        {
+            cout << "Warning: distances differ from " << queueName(QueueKind::Lazy) << endl;
+        }
+    }
+}
+
+void benchmarkParallelOnFile()
+{
+    DijkstraGraph g(0);
+    if (!readGraphFile("dijkstraInput.txt", g))
+    {
+        return;
+    }
+
+    int src;
+    cout << "Enter the source user: ";
+    cin >> src;
+
+    if (src < 0 || src >= g.V)
+    {
+        cout << "Invalid source user." << endl;
+        return;
+    }
+
+    benchmarkDeltaStepping(g, src);
+}
+
+// Answers one distance query on the file graph and compares the work with a
+// one-to-all run from the same source.
+void pointQueryOnFile()
+{
+    DijkstraGraph g(0);
+    LandmarkIndex alt;
+    if (!readGraphFile("dijkstraInput.txt", g, &alt))
+    {
+        return;
+    }
+
+    int src, dst;
+    cout << "Enter the source user: ";
+    cin >> src;
+    cout << "Enter the target user: ";
+    cin >> dst;
+
+    if (src < 0 || src >= g.V || dst < 0 || dst >= g.V)
+    {
+        cout << "Invalid user." << endl;
+        return;
+    }
+
+    PointQueryStats stats;
+    auto start = high_resolution_clock::now();
+    int distance = g.query(src, dst, stats);
+    auto stop = high_resolution_clock::now();
+
+    if (distance == INT_MAX)
+    {
+        cout << "User " << dst << " is unreachable from user " << src << endl;
+    }
+    else
+    {
+        cout << "Distance from user " << src << " to user " << dst << " : " << distance << endl;
+    }
+    cout << "Bidirectional search: " << duration_cast<microseconds>(stop - start).count() << " microseconds, settled "
+         << stats.forwardSettled << " forward + " << stats.backwardSettled << " backward" << endl;
+
+    bool fromSnapshot = !alt.landmarks.empty();
+    start = high_resolution_clock::now();
+    if (fromSnapshot || alt.build(g, landmarkOptions))
+    {
+        stop = high_resolution_clock::now();
+        if (fromSnapshot)
+        {
+            cout << "Using " << alt.landmarks.size() << " landmarks from the snapshot, tables use " << alt.memoryBytes()
+                 << " bytes" << endl;
+        }
+        else
+        {
+            cout << "Picked " << alt.landmarks.size() << " landmarks in "
+                 << duration_cast<microseconds>(stop - start).count() << " microseconds, tables use "
+                 << alt.memoryBytes() << " bytes" << endl;
+        }
+
+        start = high_resolution_clock::now();
+        int altDistance = alt.query(g, src, dst, stats);
+        stop = high_resolution_clock::now();
+        cout << "ALT search: " << duration_cast<microseconds>(stop - start).count() << " microseconds, settled "
+             << stats.forwardSettled << (altDistance == distance ? "" : " (distance differs!)") << endl;
+    }
+
+    vector<SettledVertex> settled;
+    QueueStats pruned;
+    SearchLimit limit;
+    limit.target = dst;
+    start = high_resolution_clock::now();
+    if (g.boundedSearch(src, limit, settled, pruned))
+    {
+        stop = high_resolution_clock::now();
+        cout << "Target-pruned search: " << duration_cast<microseconds>(stop - start).count()
+             << " microseconds, settled " << settled.size() + 1 << endl;
+    }
+
+    vector<int> dist;
+    QueueStats full = g.shortestPaths(src, QueueKind::FourAry, dist);
+    cout << "One-to-all search settles " << full.pops - full.stalePops << " vertices" << endl;
+}
+
+// Lists the k closest users to a source, or everyone within a distance, or
+// both, searching only as far as needed.
+void nearbyUsersOnFile()
+{
+    DijkstraGraph g(0);
+    if (!readGraphFile("dijkstraInput.txt", g))
+    {
+        return;
+    }
+
+    int src, k, radius;
+    cout << "Enter the source user: ";
+    cin >> src;
+    if (src < 0 || src >= g.V)
+    {
+        cout << "Invalid user." << endl;
+        return;
+    }
+    cout << "How many closest users (0 for no limit): ";
+    cin >> k;
+    cout << "Maximum distance (-1 for no limit): ";
+    cin >> radius;
+
+    SearchLimit limit;
+    if (k > 0)
+    {
+        limit.k = k;
+    }
+    if (radius >= 0)
+    {
+        limit.radius = radius;
+    }
+
+    vector<SettledVertex> settled;
+    QueueStats stats;
+    auto start = high_resolution_clock::now();
+    if (!g.boundedSearch(src, limit, settled, stats))
+    {
+        cout << "Early stopping needs non-negative weights." << endl;
+        return;
+    }
+    auto stop = high_resolution_clock::now();
+
+    cout << "Found " << settled.size() << " users in " << duration_cast<microseconds>(stop - start).count()
+         << " microseconds" << endl;
+    printQueueStats(stats);
+    for (const SettledVertex &entry : settled)
+    {
+        cout << "User " << entry.v << " : " << entry.dist << "\n";
+    }
+    cout.flush();
+}
+
+void batchQueriesOnFile()
+{
+    DijkstraGraph g(0);
+    if (!readGraphFile("dijkstraInput.txt", g))
+    {
+        return;
+    }
+    benchmarkBatch(g);
+}
+
+void displayDijkstraMenu()
+{
+    cout << "Dijkstra's Menu:" << endl;
+    cout << "1. Input social network manually" << endl;
+    cout << "2. Input social network from file" << endl;
+    cout << "3. Choose priority queue" << endl;
+    cout << "4. Compare priority queues on file graph" << endl;
+    cout << "5. Benchmark parallel delta-stepping on file graph" << endl;
+    cout << "6. Distance between two users on file graph" << endl;
+    cout << "7. Batch queries from every user on file graph" << endl;
+    cout << "8. Save file graph as snapshot" << endl;
+    cout << "9. Closest users to a user on file graph" << endl;
+    cout << "10. Back to main menu" << endl;
+}
+
+// bellman ford main
+void bellmanfordMain()
+{
+    while (true)
+    {
+        displayBellmenFord();
+        int choice;
+        cout << "Enter your choice: ";
+        cin >> choice;
+        system("cls");
+        BellmanFordGraph g(0, 0);
+        switch (choice)
+        {
+        case 1:
+            inputMapManually(g);
+            break;
+        case 2:
+            loadMapFromFile(g);
+            break;
+        case 3:
+            chooseBellmanMode();
+            break;
+        case 4:
+            benchmarkKernelsOnFile();
+            break;
+        case 5:
+            buildRouteIndex();
+            break;
+        case 6:
+            routeBetweenCities();
+            break;
+        case 7:
+            allPairsForCities();
+            break;
+        case 8:
+            saveCityListSnapshot();
+            break;
+        case 9:
+            streamBellmanFordOnFile();
+            break;
+        case 10:
+            liveTrafficOnFile();
+            break;
+        case 11:
+            cout << "Exiting..." << endl;
+            return;
+        default:
+            cout << "Invalid choice. Please try again." << endl;
+            continue;
+        }
+    }
+}
+
+void dijkstraMain()
+{
+    while (true)
+    {
+        displayDijkstraMenu();
+
+        int ch;
+        cout << "Enter your choice: ";
+        cin >> ch;
+        system("cls");
+        switch (ch)
+        {
+        case 1:
+            inputGraphManually();
+            break;
+        case 2:
+            loadGraphFromFile();
+            break;
+        case 3:
+            chooseDijkstraQueue();
+            break;
+        case 4:
+            compareQueuesOnFile();
+            break;
+        case 5:
+            benchmarkParallelOnFile();
+            break;
+        case 6:
+            pointQueryOnFile();
+            break;
+        case 7:
+            batchQueriesOnFile();
+            break;
+        case 8:
+            saveGraphSnapshotOnFile();
+            break;
+        case 9:
+            nearbyUsersOnFile();
+            break;
+        case 10:
+            return;
+        default:
+            cout << "Invalid choice. Please try again." << endl;
+            continue;
+        }
+    }
+}
+
+// benchmark suite
+//
+// mainProject --bench generates seeded synthetic graphs and times every
+// engine on them:
+//
+//   er    Erdos-Renyi, uniform random arcs, average out-degree 8
+//   grid  2D grid with arcs both ways between neighbours (road-like)
+//   rmat  R-MAT with (0.57, 0.19, 0.19, 0.05), power-law degrees (social-like)
+//   dag   random DAG, average out-degree 8, weights in [-50, 100]
+//
+// One-to-all: every Dijkstra queue, delta-stepping and every Bellman-Ford
+// mode; the DAG runs the Bellman-Ford modes only. Each variant gets warmup
+// runs and then timed repetitions from seeded sources.
+//
+// Point-to-point (non-negative graphs): bidirectional Dijkstra, ALT with the
+// --landmarks options and, on the road-like grid only, the contraction
+// hierarchy (contracting random and power-law graphs adds shortcuts
+// quadratically), over BENCH_POINT_QUERIES seeded (src, dst) pairs. Every
+// query is one sample, so median and p95 are per query; ALT and CH also get a
+// row with their single preprocessing time.
+//
+// All-pairs: blocked Floyd-Warshall with every tile kernel the CPU supports,
+// and Johnson, on the subgraph induced by the first BENCH_APSP_VERTICES
+// vertices; each sample is one full matrix.
+//
+// Results are median and p95 time, edges relaxed per second (from the
+// engine's own scan count; for the Dijkstra and Johnson engines, the arcs out
+// of every reached vertex; for Floyd-Warshall, its n^3 min-plus updates) and
+// the peak RSS of the process so far, as CSV or JSON on stdout.
+// A variant whose first warmup takes longer than BENCH_SLOW_MICROS is
+// reported from that single run. Before timing anything, the all-pairs
+// solvers are checked against Bellman-Ford on small regression graphs.
+const long long BENCH_SLOW_MICROS = 2000000;
+const int BENCH_POINT_QUERIES = 100;
+const int BENCH_APSP_VERTICES = 1024;
+
+struct BenchOptions
+{
+    vector<string> graphs = {"er", "grid", "rmat", "dag"};
+    vector<string> scales = {"small"};
+    int warmup = 1;
+    int reps = 5;
+    bool json = false;
+    uint64_t seed = 1;
+};
+
+struct BenchResult
+{
+    string graph, scale, engine, variant;
+    int V = 0;
+    long long E = 0;
+    int reps = 0;
+    long long medianMicros = 0, p95Micros = 0;
+    double edgesPerSecond = 0;
+    long long peakRssKb = 0;
+};
+
+// log2 of the vertex count for each scale
+bool benchScaleBits(const string &scale, int &bits)
+{
+    if (scale == "small")
+        bits = 12;
+    else if (scale == "medium")
+        bits = 16;
+    else if (scale == "large")
+        bits = 20;
+    else
+        return false;
+    return true;
+}
+
+long long peakRssKb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return (long long)(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // kilobytes on Linux
+#endif
+}
+
+int randomWeight(mt19937_64 &rng, int low, int high)
+{
+    return low + (int)(rng() % (uint64_t)(high - low + 1));
+}
+
+void generateErdosRenyi(int V, int degree, mt19937_64 &rng, vector<bellEdges> &edges)
+{
+    edges.resize((size_t)V * degree);
+    for (bellEdges &edge : edges)
+    {
+        edge = {(int)(rng() % V), (int)(rng() % V), randomWeight(rng, 1, 100)};
+    }
+}
+
+void generateGrid(int side, mt19937_64 &rng, vector<bellEdges> &edges)
+{
+    edges.clear();
+    for (int r = 0; r < side; ++r)
+    {
+        for (int c = 0; c < side; ++c)
+        {
+            int v = r * side + c;
+            if (c + 1 < side)
+            {
+                int w = randomWeight(rng, 1, 100);
+                edges.push_back({v, v + 1, w});
+                edges.push_back({v + 1, v, w});
+            }
+            if (r + 1 < side)
+            {
+                int w = randomWeight(rng, 1, 100);
+                edges.push_back({v, v + side, w});
+                edges.push_back({v + side, v, w});
+            }
+        }
+    }
+}
+
+// Each arc picks one quadrant of the adjacency matrix per bit of the vertex id.
+void generateRmat(int bits, int degree, mt19937_64 &rng, vector<bellEdges> &edges)
+{
+    const double a = 0.57, b = 0.19, c = 0.19;
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    edges.resize((size_t)degree << bits);
+    for (bellEdges &edge : edges)
+    {
+        int u = 0, v = 0;
+        for (int bit = 0; bit < bits; ++bit)
+        {
+            double p = unit(rng);
+            u = u * 2 + (p >= a + b ? 1 : 0);
+            v = v * 2 + ((p >= a && p < a + b) || p >= a + b + c ? 1 : 0);
+        }
+        edge = {u, v, randomWeight(rng, 1, 100)};
+    }
+}
+
+// Arcs only go forward in a random vertex order, so negative weights never
+// form a cycle. order[0] reaches the most vertices and is used as a source.
+void generateNegativeDag(int V, int degree, mt19937_64 &rng, vector<bellEdges> &edges, vector<int> &order)
+{
+    order.resize(V);
+    for (int v = 0; v < V; ++v)
+    {
+        order[v] = v;
+    }
+    shuffle(order.begin(), order.end(), rng);
+    edges.resize((size_t)V * degree);
+    for (bellEdges &edge : edges)
+    {
+        int i = (int)(rng() % V), j = (int)(rng() % V);
+        if (i == j)
+        {
+            j = (j + 1) % V;
+        }
+        edge = {order[min(i, j)], order[max(i, j)], randomWeight(rng, -50, 100)};
+    }
+}
+
+// Checks Floyd-Warshall with every tile kernel the CPU supports, and Johnson,
+// against Bellman-Ford from every source. Prints the first difference.
+bool allPairsAgree(const string &name, BellmanFordGraph &g, ThreadPool &pool)
+{
+    vector<DistanceMatrix> results;
+    vector<string> labels;
+    vector<int> h;
+    if (!apspPotentials(g, h))
+    {
+        cerr << "All-pairs check " << name << ": unexpected negative cycle" << endl;
+        return false;
+    }
+    for (RelaxKernel kernel : {RelaxKernel::Scalar, RelaxKernel::Avx2, RelaxKernel::Avx512})
+    {
+        if (relaxKernelSupported(kernel))
+        {
+            results.emplace_back();
+            floydWarshallBlocked(g, results.back(), pool, kernel);
+            labels.push_back("Floyd-Warshall " + relaxKernelName(kernel));
+        }
+    }
+    results.emplace_back();
+    johnson(g, h, results.back(), pool);
+    labels.push_back("Johnson");
+
+    vector<int> dist;
+    for (int src = 0; src < g.V; ++src)
+    {
+        BellmanStats stats;
+        g.solve(src, BellmanMode::Classic, dist, stats);
+        for (size_t r = 0; r < results.size(); ++r)
+        {
+            for (int v = 0; v < g.V; ++v)
+            {
+                if (results[r].at(src, v) != dist[v])
+                {
+                    cerr << "All-pairs check " << name << ": " << labels[r] << " gives " << results[r].at(src, v)
+                         << " from " << src << " to " << v << ", Bellman-Ford " << dist[v] << endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Regression cases for the all-pairs solvers: a negative arc next to a vertex
+// that reaches nothing (its "infinity" must stay infinite), an arc heavier
+// than a quarter of the int range, and seeded DAGs with negative weights.
+bool checkAllPairs(ThreadPool &pool, uint64_t seed)
+{
+    BellmanFordGraph isolated(3, 1);
+    isolated.addEdge(1, 2, -600000000, 0);
+    BellmanFordGraph heavy(2, 1);
+    heavy.addEdge(0, 1, 600000000, 0);
+    if (!allPairsAgree("isolated vertex", isolated, pool) || !allPairsAgree("heavy arc", heavy, pool))
+    {
+        return false;
+    }
+
+    mt19937_64 rng(seed);
+    for (int V : {5, 70, 150})
+    {
+        vector<bellEdges> edges;
+        vector<int> order;
+        generateNegativeDag(V, 2, rng, edges, order);
+        BellmanFordGraph dag(V, (int)edges.size());
+        dag.edges = edges;
+        if (!allPairsAgree("dag " + to_string(V), dag, pool))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs solve (which returns the edges it relaxed) warmup + reps times,
+// cycling through the sources, and summarizes the timed repetitions.
+template <class Solve>
+BenchResult measureBench(const BenchOptions &options, const vector<int> &sources, Solve solve)
+{
+    BenchResult result;
+    vector<long long> samples;
+    long long edges = 0, totalMicros = 0;
+    for (int i = 0; i < options.warmup + options.reps; ++i)
+    {
+        auto start = high_resolution_clock::now();
+        long long relaxed = solve(sources[i % sources.size()]);
+        long long micros = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        if (i >= options.warmup || (i == 0 && micros > BENCH_SLOW_MICROS))
+        {
+            samples.push_back(micros);
+            edges += relaxed;
+            totalMicros += micros;
+        }
+        if (i < options.warmup && micros > BENCH_SLOW_MICROS)
+        {
+            break;
+        }
+    }
+
+    sort(samples.begin(), samples.end());
+    result.reps = (int)samples.size();
+    result.medianMicros = samples[samples.size() / 2];
+    result.p95Micros = samples[(samples.size() * 95 + 99) / 100 - 1];
+    result.edgesPerSecond = edges / (max(totalMicros, 1LL) / 1e6);
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+void printBenchResult(const BenchResult &r, bool json, bool first)
+{
+    if (json)
+    {
+        cout << (first ? "[\n" : ",\n") << "  {\"graph\": \"" << r.graph << "\", \"scale\": \"" << r.scale
+             << "\", \"vertices\": " << r.V << ", \"edges\": " << r.E << ", \"engine\": \"" << r.engine
+             << "\", \"variant\": \"" << r.variant << "\", \"reps\": " << r.reps << ", \"median_us\": "
+             << r.medianMicros << ", \"p95_us\": " << r.p95Micros << ", \"edges_per_sec\": " << (long long)r.edgesPerSecond
+             << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+        return;
+    }
+    if (first)
+    {
+        cout << "graph,scale,vertices,edges,engine,variant,reps,median_us,p95_us,edges_per_sec,peak_rss_kb\n";
+    }
+    cout << r.graph << "," << r.scale << "," << r.V << "," << r.E << "," << r.engine << "," << r.variant << ","
+         << r.reps << "," << r.medianMicros << "," << r.p95Micros << "," << (long long)r.edgesPerSecond << ","
+         << r.peakRssKb << "\n";
+}
+
+int runBenchmarks(const BenchOptions &options)
+{
+    ThreadPool pool(workerThreads);
+    if (!checkAllPairs(pool, options.seed))
+    {
+        return 1;
+    }
+    bool first = true;
+    for (const string &scale : options.scales)
+    {
+        int bits;
+        if (!benchScaleBits(scale, bits))
+        {
+            cerr << "Unknown scale " << scale << " (small, medium or large)" << endl;
+            return 1;
+        }
+        for (const string &family : options.graphs)
+        {
+            mt19937_64 rng(options.seed);
+            int V = 1 << bits;
+            vector<bellEdges> edges;
+            vector<int> order;
+            if (family == "er")
+                generateErdosRenyi(V, 8, rng, edges);
+            else if (family == "grid")
+            {
+                int side = 1 << (bits / 2);
+                V = side * side;
+                generateGrid(side, rng, edges);
+            }
+            else if (family == "rmat")
+                generateRmat(bits, 8, rng, edges);
+            else if (family == "dag")
+                generateNegativeDag(V, 8, rng, edges, order);
+            else
+            {
+                cerr << "Unknown graph family " << family << " (er, grid, rmat or dag)" << endl;
+                return 1;
+            }
+            cerr << "Generated " << family << " " << scale << ": " << V << " vertices, " << edges.size() << " edges" << endl;
+
+            // The same seeded sources for every variant: tails of random arcs,
+            // so R-MAT does not pick isolated vertices, and early DAG vertices.
+            vector<int> sources;
+            for (int i = 0; i < 8; ++i)
+            {
+                sources.push_back(family == "dag" ? order[rng() % max(1, V / 100)] : edges[rng() % edges.size()].src);
+            }
+
+            auto report = [&](BenchResult r, const string &engine, const string &variant)
+            {
+                r.graph = family;
+                r.scale = scale;
+                r.engine = engine;
+                r.variant = variant;
+                if (r.V == 0)
+                {
+                    r.V = V;
+                    r.E = (long long)edges.size();
+                }
+                printBenchResult(r, options.json, first);
+                first = false;
+                cout.flush();
+            };
+
+            BellmanFordGraph bellman(V, (int)edges.size());
+            bellman.edges = edges;
+            vector<int> dist;
+
+            if (family != "dag")
+            {
+                DijkstraGraph g(V);
+                g.freezeFrom(edges);
+                auto reachedArcs = [&]()
+                {
+                    long long arcs = 0;
+                    for (int v = 0; v < V; ++v)
+                    {
+                        if (dist[v] != INT_MAX)
+                        {
+                            arcs += g.offsets[v + 1] - g.offsets[v];
+                        }
+                    }
+                    return arcs;
+                };
+                for (QueueKind kind : allQueues)
+                {
+                    report(measureBench(options, sources, [&](int src)
+                                        {
+                        g.shortestPaths(src, kind, dist);
+                        return reachedArcs(); }),
+                           "dijkstra", queueName(kind));
+                }
+                report(measureBench(options, sources, [&](int src)
+                                    {
+                    g.deltaStepping(src, dist, pool);
+                    return reachedArcs(); }),
+                       "delta-stepping", to_string(pool.size()) + " threads");
+
+                // point queries: seeded pairs, each query timed on its own
+                vector<pair<int, int>> pairs;
+                vector<int> pairIds;
+                for (int i = 0; i < BENCH_POINT_QUERIES; ++i)
+                {
+                    pairs.push_back({edges[rng() % edges.size()].src, edges[rng() % edges.size()].dest});
+                    pairIds.push_back(i);
+                }
+                BenchOptions perQuery = options;
+                perQuery.warmup *= BENCH_POINT_QUERIES;
+                perQuery.reps *= BENCH_POINT_QUERIES;
+                auto buildRow = [](long long micros)
+                {
+                    BenchResult r;
+                    r.reps = 1;
+                    r.medianMicros = r.p95Micros = micros;
+                    r.peakRssKb = peakRssKb();
+                    return r;
+                };
+
+                report(measureBench(perQuery, pairIds, [&](int i)
+                                    {
+                    PointQueryStats stats;
+                    g.query(pairs[i].first, pairs[i].second, stats);
+                    return stats.edgesScanned; }),
+                       "point-to-point", "bidirectional dijkstra");
+
+                LandmarkIndex alt;
+                auto start = high_resolution_clock::now();
+                alt.build(g, landmarkOptions);
+                string landmarks = to_string(alt.landmarks.size()) + " landmarks";
+                report(buildRow(microsSince(start)), "alt", "build " + landmarks);
+                report(measureBench(perQuery, pairIds, [&](int i)
+                                    {
+                    PointQueryStats stats;
+                    alt.query(g, pairs[i].first, pairs[i].second, stats);
+                    return stats.edgesScanned; }),
+                       "point-to-point", "alt " + landmarks);
+
+                if (family == "grid")
+                {
+                    ContractionHierarchy ch;
+                    start = high_resolution_clock::now();
+                    ch.build(bellman);
+                    report(buildRow(microsSince(start)), "ch", "build " + to_string(ch.shortcuts) + " shortcuts");
+                    report(measureBench(perQuery, pairIds, [&](int i)
+                                        {
+                        PointQueryStats stats;
+                        ch.query(pairs[i].first, pairs[i].second, stats);
+                        return stats.edgesScanned; }),
+                           "point-to-point", "contraction hierarchy");
+                }
+            }
+
+            for (BellmanMode mode : allBellmanModes)
+            {
+                string variant = bellmanModeName(mode);
+                if (mode == BellmanMode::Simd)
+                {
+                    variant += " " + relaxKernelName(selectedKernel);
+                }
+                report(measureBench(options, sources, [&](int src)
+                                    {
+                    BellmanStats stats;
+                    bellman.solve(src, mode, dist, stats);
+                    return stats.edgesScanned; }),
+                       "bellman-ford", variant);
+            }
+
+            // all-pairs on the induced subgraph of the first vertices
+            int n = min(V, BENCH_APSP_VERTICES);
+            vector<bellEdges> inner;
+            vector<long long> outDegree(n, 0);
+            for (const bellEdges &edge : edges)
+            {
+                if (edge.src < n && edge.dest < n)
+                {
+                    inner.push_back(edge);
+                    ++outDegree[edge.src];
+                }
+            }
+            BellmanFordGraph small(n, (int)inner.size());
+            small.edges = inner;
+            auto reportApsp = [&](BenchResult r, const string &variant)
+            {
+                r.V = n;
+                r.E = (long long)inner.size();
+                report(r, "all-pairs", variant);
+            };
+            vector<int> whole(1, 0);
+            DistanceMatrix m;
+            for (RelaxKernel kernel : {RelaxKernel::Scalar, RelaxKernel::Avx2, RelaxKernel::Avx512})
+            {
+                if (relaxKernelSupported(kernel))
+                {
+                    reportApsp(measureBench(options, whole, [&](int)
+                                            {
+                        floydWarshallBlocked(small, m, pool, kernel);
+                        return (long long)n * n * n; }),
+                               "blocked Floyd-Warshall " + relaxKernelName(kernel));
+                }
+            }
+            reportApsp(measureBench(options, whole, [&](int)
+                                    {
+                vector<int> h;
+                apspPotentials(small, h);
+                johnson(small, h, m, pool);
+                long long arcs = 0;
+                for (int u = 0; u < n; ++u)
+                {
+                    for (int v = 0; v < n; ++v)
+                    {
+                        arcs += m.at(u, v) != INT_MAX ? outDegree[v] : 0;
+                    }
+                }
+                return arcs; }),
+                       "Johnson");
+        }
+    }
+    if (options.json && !first)
+    {
+        cout << "\n]\n";
+    }
+    return 0;
+}
+
+// "a,b,c" -> {"a", "b", "c"}
+vector<string> splitList(const string &list)
+{
+    vector<string> items;
+    stringstream input(list);
+    string item;
+    while (getline(input, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// headless batch mode
+//
+// mainProject --batch [--graph=FILE] [--queries=FILE] loads one graph (or
+// its snapshot) and answers query lines from the file or stdin without any
+// menus. A query line is
+//
+//   <source> [<target>] [dijkstra|bidir|alt|delta|bf]
+//
+// where the algorithm defaults to bidir with a target and dijkstra without
+// one; blank lines and lines starting with # are skipped. Every query gets
+// exactly one output line on stdout,
+//
+//   <query> <source> <target> <distance>          with a target
+//   <query> <source> * <d0> <d1> ... <dV-1>        without one
+//   <query> error <message>
+//
+// with "inf" for unreachable vertices. Diagnostics go to stderr, so stdout
+// carries nothing but results.
+enum class BatchAlgorithm
+{
+    Dijkstra,
+    Bidirectional,
+    Alt,
+    Delta,
+    Bellman
+};
+
+bool parseBatchAlgorithm(string_view name, BatchAlgorithm &algorithm)
+{
+    const pair<const char *, BatchAlgorithm> names[] = {
+        {"dijkstra", BatchAlgorithm::Dijkstra}, {"bidir", BatchAlgorithm::Bidirectional}, {"alt", BatchAlgorithm::Alt},
+        {"delta", BatchAlgorithm::Delta}, {"bf", BatchAlgorithm::Bellman}};
+    for (const auto &entry : names)
+    {
+        if (name == entry.first)
+        {
+            algorithm = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Splits the next whitespace-separated token off the front of line.
+bool nextField(string_view &line, string_view &field)
+{
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == string_view::npos)
+    {
+        return false;
+    }
+    size_t end = line.find_first_of(" \t\r", start);
+    if (end == string_view::npos)
+    {
+        end = line.size();
+    }
+    field = line.substr(start, end - start);
+    line.remove_prefix(end);
+    return true;
+}
+
+bool parseVertex(string_view field, int &v)
+{
+    return from_chars(field.data(), field.data() + field.size(), v).ptr == field.data() + field.size();
+}
+
+// Everything the queries share: the graph stays loaded and the expensive
+// helpers (landmark tables, Bellman-Ford copy, worker pool) are built the
+// first time a query needs them.
+class BatchEngine
+{
+public:
+    DijkstraGraph g{0};
+    LandmarkIndex alt;
+    bool altReady = false;
+    BellmanFordGraph bellman{0, 0};
+    bool bellmanReady = false;
+    unique_ptr<ThreadPool> pool;
+    vector<int> dist;
+
+    // Answers one query line into out; false if it was an error line.
+    bool answer(long long query, string_view line, BufferedWriter &out);
+
+private:
+    bool fail(long long query, const char *message, BufferedWriter &out);
+};
+
+bool BatchEngine::fail(long long query, const char *message, BufferedWriter &out)
+{
+    out.number(query);
+    out.text(" error ");
+    out.text(message);
+    out.endLine();
+    return false;
+}
+
+bool BatchEngine::answer(long long query, string_view line, BufferedWriter &out)
+{
+    string_view field;
+    int src = -1, dst = -1;
+    nextField(line, field);
+    if (!parseVertex(field, src) || src < 0 || src >= g.V)
+    {
+        return fail(query, "bad source", out);
+    }
+
+    bool hasTarget = false;
+    BatchAlgorithm algorithm = BatchAlgorithm::Dijkstra;
+    bool hasAlgorithm = false;
+    while (nextField(line, field))
+    {
+        if (!hasTarget && !hasAlgorithm && parseVertex(field, dst))
+        {
+            if (dst < 0 || dst >= g.V)
+            {
+                return fail(query, "bad target", out);
+            }
+            hasTarget = true;
+        }
+        else if (!hasAlgorithm && parseBatchAlgorithm(field, algorithm))
+        {
+            hasAlgorithm = true;
+        }
+        else
+        {
+            return fail(query, "unexpected field", out);
+        }
+    }
+    if (!hasAlgorithm && hasTarget)
+    {
+        algorithm = BatchAlgorithm::Bidirectional;
+    }
+    if (algorithm != BatchAlgorithm::Bellman && g.minWeight < 0)
+    {
+        return fail(query, "negative weights need bf", out);
+    }
+
+    int distance = INT_MAX;
+    bool oneToAll = true;
+    // one-to-all answers come from and go to the graph's result cache
+    SsspAlgorithm cacheKey = algorithm == BatchAlgorithm::Delta     ? SsspAlgorithm::DeltaStepping
+                             : algorithm == BatchAlgorithm::Bellman ? SsspAlgorithm::BellmanFord
+                                                                    : SsspAlgorithm::Dijkstra;
+    switch (algorithm)
+    {
+    case BatchAlgorithm::Dijkstra:
+        if (g.cache.lookup(g.version, src, cacheKey, dist))
+        {
+            break;
+        }
+        g.shortestPaths(src, selectedQueue, dist);
+        g.cache.store(g.version, src, cacheKey, dist);
+        break;
+    case BatchAlgorithm::Delta:
+        if (g.cache.lookup(g.version, src, cacheKey, dist))
+        {
+            break;
+        }
+        if (!pool)
+        {
+            pool.reset(new ThreadPool(workerThreads));
+        }
+        g.deltaStepping(src, dist, *pool);
+        g.cache.store(g.version, src, cacheKey, dist);
+        break;
+    case BatchAlgorithm::Bellman:
+    {
+        if (g.cache.lookup(g.version, src, cacheKey, dist))
+        {
+            break;
+        }
+        if (!bellmanReady)
+        {
+            bellman = BellmanFordGraph(g.V, (int)g.edgeDest.size());
+            for (int u = 0, j = 0; u < g.V; ++u)
+            {
+                for (int k = g.offsets[u]; k < g.offsets[u + 1]; ++k, ++j)
+                {
+                    bellman.addEdge(u, g.edgeDest[k], g.edgeWeight[k], j);
+                }
+            }
+            bellmanReady = true;
+        }
+        BellmanStats stats;
+        if (!bellman.solve(src, selectedBellmanMode, dist, stats))
+        {
+            return fail(query, "negative cycle", out);
+        }
+        g.cache.store(g.version, src, cacheKey, dist);
+        break;
+    }
+    case BatchAlgorithm::Bidirectional:
+    case BatchAlgorithm::Alt:
+    {
+        if (!hasTarget)
+        {
+            return fail(query, "point algorithm needs a target", out);
+        }
+        PointQueryStats stats;
+        if (algorithm == BatchAlgorithm::Alt)
+        {
+            if (!altReady)
+            {
+                if (alt.landmarks.empty())
+                {
+                    alt.build(g, landmarkOptions);
+                }
+                altReady = true;
+            }
+            distance = alt.query(g, src, dst, stats);
+        }
+        else
+        {
+            distance = g.query(src, dst, stats);
+        }
+        oneToAll = false;
+        break;
+    }
+    }
+    if (oneToAll && hasTarget)
+    {
+        distance = dist[dst];
+    }
+
+    out.number(query);
+    out.space();
+    out.number(src);
+    out.space();
+    if (hasTarget)
+    {
+        out.number(dst);
+        out.space();
+        out.distance(distance);
+    }
+    else
+    {
+        out.text("*");
+        for (int v = 0; v < g.V; ++v)
+        {
+            out.space();
+            out.distance(dist[v]);
+        }
+    }
+    out.endLine();
+    return true;
+}
+
+int runBatch(const string &graphFile, const string &queryFile)
+{
+    // batch mode never returns to the menus, so anything the loaders print can go to stderr for good
+    cout.rdbuf(cerr.rdbuf());
+
+    BatchEngine engine;
+    if (!readGraphFile(graphFile, engine.g, &engine.alt))
+    {
+        return 1;
+    }
+
+    ifstream file;
+    if (!queryFile.empty())
+    {
+        file.open(queryFile);
+        if (!file)
+        {
+            cerr << "Unable to open file " << queryFile << endl;
+            return 1;
+        }
+    }
+    else
+    {
+        ios::sync_with_stdio(false);
+    }
+    istream &queries = queryFile.empty() ? cin : file;
+
+    BufferedWriter out(1);
+    long long answered = 0, errors = 0;
+    auto start = high_resolution_clock::now();
+    string line;
+    while (getline(queries, line))
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        ++answered;
+        if (!engine.answer(answered, line, out))
+        {
+            ++errors;
+        }
+    }
+    out.flush();
+    auto stop = high_resolution_clock::now();
+
+    long long micros = max<long long>(1, duration_cast<microseconds>(stop - start).count());
+    cerr << "Answered " << answered << " queries (" << errors << " errors) in " << micros / 1000 << " ms, "
+         << answered * 1000000 / micros << " queries/s" << endl;
+    printCacheStats(engine.g.cache.stats()); // cout goes to stderr here
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // --queue=<auto|lazy|4ary|pairing|dial|radix> forces Dijkstra's priority queue
+    // --threads=N sets the worker count of the parallel engines
+    // --bf=<classic|frontier|spfa|parallel|simd> sets the Bellman-Ford relaxation mode
+    // --landmarks=N, --landmark-select=<farthest|avoid> and --landmark-forward-only
+    // configure the ALT tables (8 bytes per vertex per landmark, 4 forward only)
+    // --batch answers queries without menus, see runBatch; --graph=FILE picks
+    // the graph (dijkstraInput.txt) and --queries=FILE the queries (stdin)
+    // --stats-json[=FILE] appends one JSON line of counters and phase times
+    // per dijkstra/bellmanFord query to FILE (stderr)
+    // --output=<text|reachable|binary> picks how query results are written
+    // and --output-file=FILE where to (stdout)
+    // --cache-mb=N sets the result cache budget per graph (64, 0 turns it off)
+    // --bench runs the synthetic benchmark suite, see runBenchmarks;
+    // --bench-graphs=er,grid,rmat,dag, --bench-scales=small,medium,large,
+    // --bench-warmup=N, --bench-reps=N, --bench-format=csv|json and --seed=N
+    bool batch = false, bench = false;
+    BenchOptions benchOptions;
+    string graphFile = "dijkstraInput.txt", queryFile;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--batch")
+        {
+            batch = true;
+        }
+        else if (arg == "--stats-json")
+        {
+            queryStatsLog = stderr;
+        }
+        else if (arg.rfind("--stats-json=", 0) == 0)
+        {
+            queryStatsLog = fopen(arg.c_str() + 13, "a");
+            if (!queryStatsLog)
+            {
+                cerr << "Unable to open file " << arg.substr(13) << endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--output=", 0) == 0)
+        {
+            if (!parseOutputFormat(arg.substr(9), selectedOutput))
+            {
+                cerr << "Unknown output format " << arg.substr(9) << endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--output-file=", 0) == 0)
+        {
+            outputFile = arg.substr(14);
+        }
+        else if (arg.rfind("--cache-mb=", 0) == 0)
+        {
+            int megabytes = atoi(arg.c_str() + 11);
+            if (megabytes < 0)
+            {
+                cerr << "--cache-mb needs a non-negative number" << endl;
+                return 1;
+            }
+            resultCacheBytes = (size_t)megabytes << 20;
+        }
+        else if (arg == "--bench")
+        {
+            bench = true;
+        }
+        else if (arg.rfind("--bench-graphs=", 0) == 0)
+        {
+            benchOptions.graphs = splitList(arg.substr(15));
+        }
+        else if (arg.rfind("--bench-scales=", 0) == 0)
+        {
+            benchOptions.scales = splitList(arg.substr(15));
+        }
+        else if (arg.rfind("--bench-warmup=", 0) == 0)
+        {
+            benchOptions.warmup = max(0, atoi(arg.c_str() + 15));
+        }
+        else if (arg.rfind("--bench-reps=", 0) == 0)
+        {
+            benchOptions.reps = atoi(arg.c_str() + 13);
+            if (benchOptions.reps < 1)
+            {
+                cerr << "--bench-reps needs a positive number" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--bench-format=csv" || arg == "--bench-format=json")
+        {
+            benchOptions.json = arg == "--bench-format=json";
+        }
+        else if (arg.rfind("--seed=", 0) == 0)
+        {
+            benchOptions.seed = strtoull(arg.c_str() + 7, nullptr, 10);
+        }
+        else if (arg.rfind("--graph=", 0) == 0)
+        {
+            graphFile = arg.substr(8);
+        }
+        else if (arg.rfind("--queries=", 0) == 0)
+        {
+            queryFile = arg.substr(10);
+        }
+        else if (arg.rfind("--queue=", 0) == 0)
+        {
+            if (!parseQueueName(arg.substr(8), selectedQueue))
+            {
+                cerr << "Unknown queue " << arg.substr(8) << endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--bf=", 0) == 0)
+        {
+            if (!parseBellmanMode(arg.substr(5), selectedBellmanMode))
+            {
+                cerr << "Unknown Bellman-Ford mode " << arg.substr(5) << endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--landmarks=", 0) == 0)
+        {
+            landmarkOptions.count = atoi(arg.c_str() + 12);
+            if (landmarkOptions.count < 0)
+            {
+                cerr << "--landmarks needs a non-negative number" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--landmark-select=farthest")
+        {
+            landmarkOptions.selection = LandmarkSelection::Farthest;
+        }
+        else if (arg == "--landmark-select=avoid")
+        {
+            landmarkOptions.selection = LandmarkSelection::Avoid;
+        }
+        else if (arg == "--landmark-forward-only")
+        {
+            landmarkOptions.forwardOnly = true;
+        }
+        else if (arg.rfind("--threads=", 0) == 0)
+        {
+            workerThreads = atoi(arg.c_str() + 10);
+            if (workerThreads < 1)
+            {
+                cerr << "--threads needs a positive number" << endl;
+                return 1;
+            }
+        }
+        else
+        {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (batch)
+    {
+        return runBatch(graphFile, queryFile);
+    }
+    if (bench)
+    {
+        return runBenchmarks(benchOptions);
+    }
+    if (selectedOutput == OutputFormat::Binary && outputFile.empty())
+    {
+        cerr << "--output=binary needs --output-file, stdout also carries the menus" << endl;
+        return 1;
+    }
+
     system("cls");
     while (true)
     {